@@ -2,56 +2,76 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ParseFramework.h"
+#include "SimdUtil.h"
 
 
-ParseRule* AlphabetRule_Create(ParseScheme* scheme, char* alphabet) {
+static ParseRule* createAlphabetRule(ParseScheme* scheme, char* alphabet, bool caseInsensitive) {
 	if((scheme == NULL) || (scheme->errorState != 0)) {
 		return NULL;
 	}
 
+	if(alphabet == NULL) {
+		fprintf(stderr, "Error: attempting to create an alphabet rule from a null string!\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
 	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
 
 	if(ret == NULL) {
 		return NULL;
 	}
 
-	ret->alphabetRule = (AlphabetParseRule*) malloc(sizeof(AlphabetParseRule));	
+	size_t alphabetLen = strlen(alphabet);
+	uint32_t offset = ParseScheme_AddString(scheme, alphabet, alphabetLen);
 
-	if(ret->alphabetRule == NULL) {
-		fprintf(stderr, "Error: unable to allocate alphabet rule!\n");
-		ParseScheme_Free(scheme);
-		scheme->errorState = 2;
+	if(offset == UINT32_MAX) {
 		return NULL;
 	}
 
-	ret->ruleType = PARSE_RULE_ALPHABET;
+	if(caseInsensitive) {
+		for(size_t i = 0; i < alphabetLen; i++) {
+			scheme->stringPool[offset + i] = SIMD_FOLD_ASCII_CASE(alphabet[i]);
+		}
+	}
 
-	ret->alphabetRule->alphabet = alphabet;
-	ret->alphabetRule->alphabetLen = strlen(alphabet);
+	ret->alphabetRule = (AlphabetParseRule) {
+		.alphabet = offset,
+		.alphabetLen = (uint32_t) alphabetLen,
+		.caseInsensitive = caseInsensitive
+	};
+	ret->ruleType = PARSE_RULE_ALPHABET;
 
-	return ret;
+	return ParseScheme_InternRule(scheme, ret);
 }
 
-void AlphabetRule_Free(AlphabetParseRule* rule) {
-	if(rule == NULL) return;
+ParseRule* AlphabetRule_Create(ParseScheme* scheme, char* alphabet) {
+	return createAlphabetRule(scheme, alphabet, false);
+}
 
-	//free(rule->alphabetRule->alphabet);
-	rule->alphabet = NULL;
-	free(rule);
+ParseRule* AlphabetRule_CreateCaseInsensitive(ParseScheme* scheme, char* alphabet) {
+	return createAlphabetRule(scheme, alphabet, true);
 }
 
-ParseResult AlphabetRule_Parse(AlphabetParseRule* rule, char* str, ParseResult* result_ret) {
+ParseResult AlphabetRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	if(rule == NULL) {
 		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
-	if(str[0] == '\0') {
+	ParseContext_MarkExamined(ctx, str, 1);
+
+	if(str >= ctx->input + ctx->inputLen) {
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
-	for(size_t i = 0; i < rule->alphabetLen; i++) {
-		if(str[0] == rule->alphabet[i]) {
+	AlphabetParseRule* data = &rule->alphabetRule;
+	const char* alphabet = Rule_GetText(rule);
+	char c = data->caseInsensitive? SIMD_FOLD_ASCII_CASE(str[0]) : str[0];
+
+	for(size_t i = 0; i < data->alphabetLen; i++) {
+		if(c == alphabet[i]) {
 			return setParseResult(result_ret, true, str, 1);
 		}
 	}
@@ -67,7 +87,7 @@ ParseResult AlphabetRule_Parse(AlphabetParseRule* rule, char* str, ParseResult*
 // 	fprintf(fout, "Alphabet(\"%s\")", rule->alphabet);
 // }
 
-void AlphabetRule_Print(AlphabetParseRule* rule, FILE* fout) {
-	fprintf(fout, "Alphabet(\"%s\")", rule->alphabet);
+void AlphabetRule_Print(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "%s(\"%s\")", rule->alphabetRule.caseInsensitive? "AlphabetCaseInsensitive" : "Alphabet", Rule_GetText(rule));
 }
 
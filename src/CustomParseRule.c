@@ -0,0 +1,26 @@
+#include <stdio.h>
+#include "ParseFramework.h"
+
+ParseRule* CustomRule_Create(ParseScheme* scheme, ParseRuleType ruleType, void* data) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if((ruleType < PARSE_RULE_NUM_BUILTIN_TYPES) || (ParseRuleType_GetVTable(ruleType) == NULL)) {
+		fprintf(stderr, "Error: custom rules have to use a registered rule type.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 4;
+		return NULL;
+	}
+
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->customRule.data = data;
+	ret->ruleType = ruleType;
+
+	return ret;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+#include "ParseMemo.h"
+
+ParseRule* CutRule_Create(ParseScheme* scheme) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	// Cut rules don't have any data, so there is nothing to allocate.
+	ret->ruleType = PARSE_RULE_CUT;
+
+	return ret;
+}
+
+ParseResult CutRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	// A cut always matches the empty string. Its only effect is to mark the result as committed, which
+	// tells every enclosing rule that it may no longer backtrack to before this point.
+	size_t offset = str - ctx->input;
+	if(offset > ctx->cutOffset) {
+		ctx->cutOffset = offset;
+	}
+
+	// Nothing before the cut can be backtracked over anymore, so its results won't be looked up again, and its
+	// events are certain.
+	if((ctx->memo != NULL) && ctx->ownsMemo) {
+		ParseMemo_DiscardBefore(ctx->memo, offset);
+	}
+
+	if((ctx->events != NULL) && !ParseEvents_Flush(ctx->events)) {
+		ctx->abortReason = PARSE_ABORTED_BY_CALLBACK;
+	}
+
+	return setParseResultWithCut(result_ret, true, str, 0, true);
+}
+
+void CutRule_Print(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "Cut");
+}
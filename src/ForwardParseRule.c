@@ -58,6 +58,8 @@ ParseRule* ForwardRule_SetValue(ParseScheme* scheme, ParseRule* forwardRule, Par
 
 	(*forwardRule) = (*ruleValue);
 	forwardRule->wasForwardDeclaration = true;
+	// The DFA belongs to ruleValue, which is the one that will free it.
+	forwardRule->hasDfa = false;
 
 	scheme->numUnresolvedForwardRules--;
 
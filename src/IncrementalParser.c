@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseMemo.h"
+#include "IncrementalParser.h"
+
+IncrementalParser* IncrementalParser_Create(ParseRule* rule, const char* text, size_t textLen) {
+	if((rule == NULL) || ((text == NULL) && (textLen > 0))) {
+		fprintf(stderr, "Error: attempting to create an incremental parser with a null rule or text.\n");
+		return NULL;
+	}
+
+	IncrementalParser* ret = (IncrementalParser*) malloc(sizeof(IncrementalParser));
+	char* textCopy = (char*) malloc(textLen + 1);
+	ParseMemo* memo = ParseMemo_Create(textLen);
+
+	if((ret == NULL) || (textCopy == NULL) || (memo == NULL)) {
+		fprintf(stderr, "Error: unable to allocate incremental parser!\n");
+
+		free(ret);
+		free(textCopy);
+		ParseMemo_Free(memo);
+		return NULL;
+	}
+
+	if(textLen > 0) {
+		memcpy(textCopy, text, textLen);
+	}
+
+	ret->rule = rule;
+	ret->text = textCopy;
+	ret->textLen = textLen;
+	ret->maxTextLen = textLen + 1;
+	ret->memo = memo;
+	ret->errorState = 0;
+
+	return ret;
+}
+
+void IncrementalParser_Free(IncrementalParser* parser) {
+	if(parser == NULL) {
+		return;
+	}
+
+	free(parser->text);
+	ParseMemo_Free(parser->memo);
+	free(parser);
+}
+
+ParseResult IncrementalParser_Parse(IncrementalParser* parser, ParseResult* result_ret) {
+	if((parser == NULL) || (parser->errorState != 0)) {
+		fprintf(stderr, "Error: attempting to parse with a null or broken incremental parser.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	ParseContext ctx;
+	ParseContext_Init(&ctx, parser->text, parser->textLen);
+	ctx.memo = parser->memo;
+
+	ParseResult result = Rule_ParseWithContext(parser->rule, &ctx, parser->text, result_ret);
+
+	ParseContext_Free(&ctx);
+
+	return result;
+}
+
+bool IncrementalParser_Edit(IncrementalParser* parser, size_t offset, size_t removedLen, const char* inserted, size_t insertedLen) {
+	if((parser == NULL) || (parser->errorState != 0)) {
+		return false;
+	}
+
+	if((offset > parser->textLen) || (removedLen > parser->textLen - offset) || ((inserted == NULL) && (insertedLen > 0))) {
+		fprintf(stderr, "Error: attempting to make an edit outside of the incremental parser's text.\n");
+		return false;
+	}
+
+	size_t newLen = parser->textLen - removedLen + insertedLen;
+
+	if(newLen >= parser->maxTextLen) {
+		size_t newMax = parser->maxTextLen * 2;
+		if(newMax <= newLen) {
+			newMax = newLen + 1;
+		}
+
+		char* newText = (char*) realloc(parser->text, newMax);
+
+		if(newText == NULL) {
+			fprintf(stderr, "Error: unable to grow incremental parser's text.\n");
+			parser->errorState = 2;
+			return false;
+		}
+
+		parser->text = newText;
+		parser->maxTextLen = newMax;
+	}
+
+	memmove(parser->text + offset + insertedLen, parser->text + offset + removedLen, parser->textLen - offset - removedLen);
+	if(insertedLen > 0) {
+		memcpy(parser->text + offset, inserted, insertedLen);
+	}
+	parser->textLen = newLen;
+
+	ParseMemo_Edit(parser->memo, offset, removedLen, insertedLen);
+
+	return true;
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+#include "SimdUtil.h"
+#include "LazyParseRule.h"
+
+static ParseRule* createLazyRule(ParseScheme* scheme, uint32_t skipRule, char open, char close, char quote, char escape, ParseRule* rule) {
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->lazyRule = (LazyParseRule) {
+		.rule = Rule_GetIndex(rule),
+		.skipRule = skipRule,
+		.open = open,
+		.close = close,
+		.quote = quote,
+		// A doubled quote needs no escape, since it ends one quoted part and starts the next.
+		.escape = (escape == quote)? 0 : escape
+	};
+
+	ret->ruleType = PARSE_RULE_LAZY;
+
+	return ret;
+}
+
+ParseRule* LazyRule_CreateBalanced(ParseScheme* scheme, char open, char close, char quote, char escape, ParseRule* rule) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to create a lazy rule around a null rule.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
+	if((open == close) || (open == 0) || (close == 0) || (quote == open) || (quote == close)) {
+		fprintf(stderr, "Error: a lazy rule's delimiters must be distinct, and can't be null characters.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 4;
+		return NULL;
+	}
+
+	return createLazyRule(scheme, UINT32_MAX, open, close, quote, escape, rule);
+}
+
+ParseRule* LazyRule_CreateWithSkip(ParseScheme* scheme, ParseRule* skipRule, ParseRule* rule) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if((skipRule == NULL) || (rule == NULL)) {
+		fprintf(stderr, "Error: attempting to create a lazy rule with a null rule.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
+	return createLazyRule(scheme, Rule_GetIndex(skipRule), 0, 0, 0, 0, rule);
+}
+
+// Returns the length of the balanced region at the start of str, or 0 if there is none. Sets examined_ret to
+// how much of str was looked at.
+static size_t findBalancedEnd(LazyParseRule* lazy, const char* str, size_t len, size_t* examined_ret) {
+	(*examined_ret) = (len > 0)? 1 : 0;
+
+	if((len == 0) || (str[0] != lazy->open)) {
+		return 0;
+	}
+
+	char stops[3] = { lazy->open, lazy->close, lazy->quote };
+	size_t numStops = (lazy->quote != 0)? 3 : 2;
+	char quoteStops[2] = { lazy->quote, lazy->escape };
+	size_t numQuoteStops = (lazy->escape != 0)? 2 : 1;
+
+	size_t depth = 1;
+	size_t i = 1;
+
+	while(true) {
+		i += SimdUtil_FindAnyOf(str + i, len - i, stops, numStops);
+		if(i >= len) {
+			break;
+		}
+
+		char c = str[i++];
+
+		if(c == lazy->open) {
+			depth++;
+		} else if(c == lazy->close) {
+			if(--depth == 0) {
+				(*examined_ret) = i;
+				return i;
+			}
+		} else {
+			// Inside quotes, only the closing quote and escapes matter.
+			while(true) {
+				i += SimdUtil_FindAnyOf(str + i, len - i, quoteStops, numQuoteStops);
+				if(i >= len) {
+					break;
+				}
+				if(str[i++] == lazy->quote) {
+					break;
+				}
+				i++;
+			}
+			if(i >= len) {
+				break;
+			}
+		}
+	}
+
+	(*examined_ret) = len;
+	return 0;
+}
+
+ParseResult LazyRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule->lazyRule.skipRule != UINT32_MAX) {
+		ParseResult skipRes;
+		Rule_ParseWithContext(rule->scheme->rules + rule->lazyRule.skipRule, ctx, str, &skipRes);
+
+		if(skipRes.success) {
+			return setParseResultWithCut(result_ret, true, str, skipRes.length, skipRes.cut);
+		}
+		return setParseResultWithCut(result_ret, false, NULL, 0, skipRes.cut);
+	}
+
+	size_t examined;
+	size_t length = findBalancedEnd(&rule->lazyRule, str, (ctx->input + ctx->inputLen) - str, &examined);
+	ParseContext_MarkExamined(ctx, str, examined);
+
+	if(length == 0) {
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	return setParseResult(result_ret, true, str, length);
+}
+
+ParseResult LazyRule_Expand(ParseRule* rule, ParseContext* ctx, char* str, size_t length, ParseResult* result_ret) {
+	if((rule == NULL) || (ctx == NULL) || (str == NULL)) {
+		fprintf(stderr, "Error: attempting to expand a lazy rule with a null rule, context or string.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	if(rule->ruleType != PARSE_RULE_LAZY) {
+		fprintf(stderr, "Error: attempting to expand a rule that isn't lazy.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	if((str < ctx->input) || (length > (size_t) ((ctx->input + ctx->inputLen) - str))) {
+		fprintf(stderr, "Error: attempting to expand a lazy rule's region that isn't inside the context's input.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	// The inner rule only sees the region, as if the input ended there. What the memo holds was found with
+	// the rest of the input in view, so it isn't used.
+	ParseContext region = (*ctx);
+	region.inputLen = (size_t) ((str + length) - ctx->input);
+	region.memo = NULL;
+	region.ownsMemo = false;
+
+	// The region can still be rejected after the inner rule matched, so its events are held until then.
+	size_t pendingMark = 0;
+	if(ctx->events != NULL) {
+		pendingMark = ctx->events->numPending;
+		ctx->events->numUnsafeOpen++;
+	}
+
+	ParseResult result = Rule_ParseWithContext(Rule_GetInnerRule(rule), &region, str, result_ret);
+	bool matchedRegion = result.success && (result.length == length);
+
+	if(ctx->events != NULL) {
+		ctx->events->numUnsafeOpen--;
+		if(!matchedRegion) {
+			ParseEvents_Retract(ctx->events, pendingMark);
+		} else if((ctx->events->numUnsafeOpen == 0) && !ParseEvents_Flush(ctx->events)) {
+			region.abortReason = PARSE_ABORTED_BY_CALLBACK;
+		}
+	}
+
+	ctx->numSteps = region.numSteps;
+	ctx->nextLimitCheck = region.nextLimitCheck;
+	ctx->abortReason = region.abortReason;
+	if(region.examinedEnd > ctx->examinedEnd) {
+		ctx->examinedEnd = region.examinedEnd;
+	}
+
+	if(result.success && !matchedRegion) {
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	return result;
+}
+
+void LazyRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+	fprintf(fout, "Lazy(");
+	Rule_PrintSimpleRulePointer(Rule_GetInnerRule(rule), fout);
+	if(rule->lazyRule.skipRule != UINT32_MAX) {
+		fprintf(fout, ", ");
+		Rule_PrintSimpleRulePointer(rule->scheme->rules + rule->lazyRule.skipRule, fout);
+	} else {
+		fprintf(fout, ", \"%c%c\"", rule->lazyRule.open, rule->lazyRule.close);
+	}
+	fprintf(fout, ")");
+
+	if(depth < maxDepth) {
+		Rule_PrintDeep(Rule_GetInnerRule(rule), fout, depth + 1, maxDepth, indentStr);
+	}
+}
+
+void LazyRule_Print(ParseRule* rule, FILE* fout) {
+	LazyRule_PrintDeep(rule, fout, 0, 0, "");
+}
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "ParseFramework.h"
+#include "ParseDfa.h"
+#include "Lexer.h"
+
+const size_t LEXER_BUFFER_LENGTH = 16;
+const size_t TOKEN_STREAM_BUFFER_LENGTH = 256;
+
+Lexer* Lexer_Create() {
+	Lexer* ret = (Lexer*) malloc(sizeof(Lexer));
+
+	if(ret == NULL) {
+		fprintf(stderr, "Error: unable to allocate lexer!\n");
+		return NULL;
+	}
+
+	ret->defs = NULL;
+	ret->numDefs = 0;
+	ret->maxDefs = 0;
+	ret->dfa = NULL;
+	ret->errorState = 0;
+
+	return ret;
+}
+
+void Lexer_Free(Lexer* lexer) {
+	if(lexer == NULL) {
+		return;
+	}
+
+	free(lexer->defs);
+	ParseDfa_Free(lexer->dfa);
+	free(lexer);
+}
+
+static bool addDef(Lexer* lexer, int tokenType, bool skip, ParseRule* rule) {
+	if((lexer == NULL) || (lexer->errorState != 0)) {
+		return false;
+	}
+
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to add a null rule to a lexer!\n");
+		lexer->errorState = 3;
+		return false;
+	}
+
+	if(lexer->numDefs == lexer->maxDefs) {
+		size_t newLength = lexer->maxDefs + LEXER_BUFFER_LENGTH;
+		LexerTokenDef* newDefs = (LexerTokenDef*) realloc(lexer->defs, sizeof(LexerTokenDef) * newLength);
+
+		if(newDefs == NULL) {
+			fprintf(stderr, "Error: unable to allocate lexer token!\n");
+			lexer->errorState = 1;
+			return false;
+		}
+
+		lexer->defs = newDefs;
+		lexer->maxDefs = newLength;
+	}
+
+	lexer->defs[lexer->numDefs++] = (LexerTokenDef) {
+		.tokenType = tokenType,
+		.skip = skip,
+		.rule = rule
+	};
+
+	// The DFA no longer covers every token, so it will have to be rebuilt.
+	ParseDfa_Free(lexer->dfa);
+	lexer->dfa = NULL;
+
+	return true;
+}
+
+bool Lexer_AddToken(Lexer* lexer, int tokenType, ParseRule* rule) {
+	return addDef(lexer, tokenType, false, rule);
+}
+
+bool Lexer_AddSkip(Lexer* lexer, ParseRule* rule) {
+	return addDef(lexer, -1, true, rule);
+}
+
+static bool buildDfa(Lexer* lexer) {
+	ParseRule** rules = (ParseRule**) malloc(sizeof(ParseRule*) * (lexer->numDefs + 1));
+
+	if(rules == NULL) {
+		fprintf(stderr, "Error: unable to allocate lexer DFA!\n");
+		lexer->errorState = 2;
+		return false;
+	}
+
+	for(size_t i = 0; i < lexer->numDefs; i++) {
+		if(!ParseDfa_IsRegular(lexer->defs[i].rule)) {
+			fprintf(stderr, "Error: lexer token %lu isn't a regular rule: ", i);
+			Rule_Print(lexer->defs[i].rule, stderr);
+			fprintf(stderr, "\n");
+
+			free(rules);
+			lexer->errorState = 4;
+			return false;
+		}
+		rules[i] = lexer->defs[i].rule;
+	}
+
+	lexer->dfa = ParseDfa_Compile(rules, lexer->numDefs);
+	free(rules);
+
+	if(lexer->dfa == NULL) {
+		fprintf(stderr, "Error: unable to build lexer DFA!\n");
+		lexer->errorState = 2;
+		return false;
+	}
+
+	return true;
+}
+
+static bool addToken(TokenStream* ret, size_t* maxTokens, int tokenType, size_t offset, size_t length) {
+	if(ret->numTokens == (*maxTokens)) {
+		size_t newLength = (*maxTokens) * 2;
+		Token* newTokens = (Token*) realloc(ret->tokens, sizeof(Token) * newLength);
+
+		if((newTokens == NULL) || (newLength > INT32_MAX)) {
+			return false;
+		}
+
+		ret->tokens = newTokens;
+		(*maxTokens) = newLength;
+	}
+
+	ret->tokens[ret->numTokens++] = (Token) {
+		.tokenType = tokenType,
+		.offset = offset,
+		.length = length
+	};
+
+	return true;
+}
+
+TokenStream* Lexer_Tokenize(Lexer* lexer, char* input, size_t inputLen) {
+	if((lexer == NULL) || (lexer->errorState != 0)) {
+		return NULL;
+	}
+
+	if((lexer->dfa == NULL) && !buildDfa(lexer)) {
+		return NULL;
+	}
+
+	TokenStream* ret = (TokenStream*) malloc(sizeof(TokenStream));
+	size_t maxTokens = TOKEN_STREAM_BUFFER_LENGTH;
+
+	if(ret != NULL) {
+		ret->tokens = (Token*) malloc(sizeof(Token) * maxTokens);
+		ret->tokenAtOffset = (int32_t*) malloc(sizeof(int32_t) * (inputLen + 1));
+	}
+
+	if((ret == NULL) || (ret->tokens == NULL) || (ret->tokenAtOffset == NULL)) {
+		fprintf(stderr, "Error: unable to allocate token stream!\n");
+		TokenStream_Free(ret);
+		return NULL;
+	}
+
+	ret->input = input;
+	ret->inputLen = inputLen;
+	ret->numTokens = 0;
+
+	size_t offset = 0;
+	// Where the skipped input in front of the next token starts.
+	size_t skipStart = 0;
+
+	while(offset < inputLen) {
+		size_t length;
+		int defIndex;
+
+		if(!ParseDfa_Match(lexer->dfa, input + offset, inputLen - offset, &length, &defIndex, NULL) || (length == 0)) {
+			break;
+		}
+
+		LexerTokenDef* def = lexer->defs + defIndex;
+
+		if(!def->skip) {
+			if(!addToken(ret, &maxTokens, def->tokenType, offset, length)) {
+				fprintf(stderr, "Error: unable to allocate token stream!\n");
+				TokenStream_Free(ret);
+				return NULL;
+			}
+
+			int32_t tokenIndex = (int32_t) (ret->numTokens - 1);
+
+			for(size_t i = skipStart; i <= offset; i++) {
+				ret->tokenAtOffset[i] = tokenIndex;
+			}
+			for(size_t i = offset + 1; i < offset + length; i++) {
+				ret->tokenAtOffset[i] = -1;
+			}
+
+			skipStart = offset + length;
+		}
+
+		offset += length;
+	}
+
+	ret->errorOffset = offset;
+
+	for(size_t i = skipStart; i <= inputLen; i++) {
+		ret->tokenAtOffset[i] = -1;
+	}
+
+	return ret;
+}
+
+void TokenStream_Free(TokenStream* tokens) {
+	if(tokens == NULL) {
+		return;
+	}
+
+	free(tokens->tokens);
+	tokens->tokens = NULL;
+	free(tokens->tokenAtOffset);
+	tokens->tokenAtOffset = NULL;
+	free(tokens);
+}
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+#include "OperatorPrecedenceParseRule.h"
+
+// Expressions nested deeper than this keep their frames on the heap.
+#define OPERATOR_PRECEDENCE_LOCAL_FRAMES 32
+
+ParseRule* OperatorPrecedenceRule_Create(ParseScheme* scheme, ParseRule* operand, const ParseOperator* operators, size_t numOperators) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if((operand == NULL) || ((operators == NULL) && (numOperators > 0))) {
+		fprintf(stderr, "Error: attempting to create an operator precedence rule with a null operand or operators.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
+	for(size_t i = 0; i < numOperators; i++) {
+		if(operators[i].rule == NULL) {
+			fprintf(stderr, "Error: attempting to create an operator precedence rule with a null operator.\n");
+			ParseScheme_Free(scheme);
+			scheme->errorState = 3;
+			return NULL;
+		}
+		if((unsigned) operators[i].kind > PARSE_OPERATOR_INFIX_NONE) {
+			fprintf(stderr, "Error: attempting to create an operator precedence rule with an unknown kind of operator.\n");
+			ParseScheme_Free(scheme);
+			scheme->errorState = 4;
+			return NULL;
+		}
+	}
+
+	uint32_t operandIndex = Rule_GetIndex(operand);
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+	ParseRule** rules = (ParseRule**) malloc(sizeof(ParseRule*) * (numOperators + 1));
+	char* info = (char*) malloc(2 * numOperators + 1);
+
+	if((ret == NULL) || (rules == NULL) || (info == NULL)) {
+		if(scheme->errorState == 0) {
+			fprintf(stderr, "Error: unable to allocate operator precedence rule data!\n");
+			scheme->errorState = 2;
+		}
+		free(rules);
+		free(info);
+		return NULL;
+	}
+
+	for(size_t i = 0; i < numOperators; i++) {
+		rules[i] = operators[i].rule;
+		info[2 * i] = (char) operators[i].kind;
+		info[2 * i + 1] = (char) operators[i].precedence;
+	}
+
+	uint32_t firstOperator = ParseScheme_AddRulesList(scheme, rules, numOperators);
+	uint32_t operatorInfo = (firstOperator != UINT32_MAX)? ParseScheme_AddString(scheme, info, 2 * numOperators) : UINT32_MAX;
+
+	free(rules);
+	free(info);
+
+	if(operatorInfo == UINT32_MAX) {
+		return NULL;
+	}
+
+	ret->operatorRule = (OperatorPrecedenceParseRule) {
+		.operand = operandIndex,
+		.firstOperator = firstOperator,
+		.numOperators = (uint32_t) numOperators,
+		.operatorInfo = operatorInfo
+	};
+
+	ret->ruleType = PARSE_RULE_OPERATOR_PRECEDENCE;
+
+	return ret;
+}
+
+typedef enum {
+	OPERATOR_FRAME_ROOT,
+	OPERATOR_FRAME_PREFIX,
+	OPERATOR_FRAME_INFIX
+} OperatorFrameType;
+
+// Stands for an expression that hasn't ended yet: the whole one, or the operand of a prefix or infix operator.
+typedef struct {
+	OperatorFrameType type;
+	// Operators with a lower precedence end the expression.
+	int minPrecedence;
+	// The precedence of the last non-associative operator in the expression, or -1.
+	int lastNonAssociative;
+
+	// The operator that started the frame, where it started, and how many events were pending before it, so
+	// that it can be given up on.
+	uint32_t op;
+	size_t opStart;
+	size_t pendingMark;
+	bool opCut;
+} OperatorFrame;
+
+typedef struct {
+	OperatorFrame* frames;
+	size_t len;
+	size_t max;
+	OperatorFrame localFrames[OPERATOR_PRECEDENCE_LOCAL_FRAMES];
+} OperatorStack;
+
+static bool pushFrame(OperatorStack* stack, OperatorFrame frame) {
+	if(stack->len == stack->max) {
+		size_t newLength = stack->max * 2;
+		OperatorFrame* newFrames = (stack->frames == stack->localFrames)?
+			(OperatorFrame*) malloc(sizeof(OperatorFrame) * newLength) :
+			(OperatorFrame*) realloc(stack->frames, sizeof(OperatorFrame) * newLength);
+
+		if(newFrames == NULL) {
+			fprintf(stderr, "Error: unable to allocate space for a nested expression!\n");
+			return false;
+		}
+
+		if(stack->frames == stack->localFrames) {
+			memcpy(newFrames, stack->localFrames, sizeof(OperatorFrame) * stack->len);
+		}
+
+		stack->frames = newFrames;
+		stack->max = newLength;
+	}
+
+	stack->frames[stack->len++] = frame;
+	return true;
+}
+
+static size_t getPendingMark(ParseContext* ctx) {
+	return (ctx->events != NULL)? ctx->events->numPending : 0;
+}
+
+static void retractEvents(ParseContext* ctx, size_t pendingMark) {
+	if(ctx->events != NULL) {
+		ParseEvents_Retract(ctx->events, pendingMark);
+	}
+}
+
+// The operator that follows an operand. Every frame that is still open looks at the same operator once its
+// inner frames are done, so it is only parsed once.
+typedef struct {
+	size_t offset;
+	bool found;
+	uint32_t op;
+	size_t length;
+	bool cut;
+	size_t pendingMark;
+} FollowingOperator;
+
+// Returns false if an operator failed with a cut.
+static bool findFollowingOperator(ParseRule* rule, ParseContext* ctx, char* str, size_t offset, FollowingOperator* following) {
+	if(following->offset == offset) {
+		return true;
+	}
+
+	(*following) = (FollowingOperator) { .offset = offset, .found = false, .pendingMark = getPendingMark(ctx) };
+
+	for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+		ParseOperatorKind kind = Rule_GetOperatorKind(rule, i);
+		if(kind == PARSE_OPERATOR_PREFIX) {
+			continue;
+		}
+
+		ParseResult result;
+		if(Rule_ParseWithContext(Rule_GetOperatorRule(rule, i), ctx, str + offset, &result).success) {
+			// A postfix operator that doesn't consume anything would apply forever, and so would an infix one
+			// whose right operand, or a prefix operator before it, doesn't consume anything either.
+			if(result.length == 0) {
+				retractEvents(ctx, following->pendingMark);
+				return !result.cut;
+			}
+
+			following->found = true;
+			following->op = (uint32_t) i;
+			following->length = result.length;
+			following->cut = result.cut;
+			return true;
+		}
+
+		if(result.cut) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Precedence climbing, with a stack of frames instead of recursion so that long chains of operators don't
+// take any native stack. After an operand, the following operator either continues the innermost expression
+// or, if it binds more loosely, ends it and is looked at again by the one around it.
+ParseResult OperatorPrecedenceRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	OperatorStack stack;
+	stack.frames = stack.localFrames;
+	stack.len = 0;
+	stack.max = OPERATOR_PRECEDENCE_LOCAL_FRAMES;
+
+	pushFrame(&stack, (OperatorFrame) { .type = OPERATOR_FRAME_ROOT, .minPrecedence = 0, .lastNonAssociative = -1 });
+
+	FollowingOperator following = { .offset = SIZE_MAX };
+	ParseRule* operand = Rule_GetOperandRule(rule);
+	size_t numOperators = rule->operatorRule.numOperators;
+
+	size_t offset = 0;
+	size_t nextPrefix = 0;
+	bool expectOperand = true;
+	bool cut = false;
+	bool success = false;
+
+	while(true) {
+		OperatorFrame* top = &stack.frames[stack.len - 1];
+
+		if(expectOperand) {
+			bool foundPrefix = false;
+
+			for(size_t i = nextPrefix; i < numOperators; i++) {
+				if(Rule_GetOperatorKind(rule, i) != PARSE_OPERATOR_PREFIX) {
+					continue;
+				}
+
+				size_t pendingMark = getPendingMark(ctx);
+				ParseResult result;
+				if(!Rule_ParseWithContext(Rule_GetOperatorRule(rule, i), ctx, str + offset, &result).success) {
+					if(result.cut) {
+						cut = true;
+						goto done;
+					}
+					continue;
+				}
+
+				// A prefix operator that doesn't consume anything could apply forever.
+				if(result.length == 0) {
+					retractEvents(ctx, pendingMark);
+					if(result.cut) {
+						cut = true;
+						goto done;
+					}
+					continue;
+				}
+
+				if(!pushFrame(&stack, (OperatorFrame) {
+					.type = OPERATOR_FRAME_PREFIX,
+					.minPrecedence = Rule_GetOperatorPrecedence(rule, i),
+					.lastNonAssociative = -1,
+					.op = (uint32_t) i,
+					.opStart = offset,
+					.pendingMark = pendingMark,
+					.opCut = result.cut
+				})) {
+					goto done;
+				}
+
+				offset += result.length;
+				nextPrefix = 0;
+				foundPrefix = true;
+				break;
+			}
+
+			if(foundPrefix) {
+				continue;
+			}
+
+			ParseResult result;
+			if(Rule_ParseWithContext(operand, ctx, str + offset, &result).success) {
+				offset += result.length;
+				cut = cut || result.cut;
+				expectOperand = false;
+				continue;
+			}
+
+			if(result.cut || (top->type == OPERATOR_FRAME_ROOT) || top->opCut) {
+				cut = cut || result.cut || top->opCut;
+				goto done;
+			}
+
+			// Without an operand, the innermost operator is given up on. A prefix operator's place can still
+			// hold another prefix operator or an operand, but an infix operator ends the expression.
+			retractEvents(ctx, top->pendingMark);
+			offset = top->opStart;
+
+			if(top->type == OPERATOR_FRAME_INFIX) {
+				success = true;
+				goto done;
+			}
+
+			nextPrefix = top->op + 1;
+			stack.len--;
+			continue;
+		}
+
+		if(!findFollowingOperator(rule, ctx, str, offset, &following)) {
+			cut = true;
+			goto done;
+		}
+
+		if(!following.found) {
+			success = true;
+			goto done;
+		}
+
+		ParseOperatorKind kind = Rule_GetOperatorKind(rule, following.op);
+		int precedence = Rule_GetOperatorPrecedence(rule, following.op);
+
+		if(precedence < top->minPrecedence) {
+			stack.len--;
+
+			if(top->type == OPERATOR_FRAME_INFIX) {
+				bool nonAssociative = (Rule_GetOperatorKind(rule, top->op) == PARSE_OPERATOR_INFIX_NONE);
+				stack.frames[stack.len - 1].lastNonAssociative = nonAssociative? Rule_GetOperatorPrecedence(rule, top->op) : -1;
+			}
+			continue;
+		}
+
+		if((kind == PARSE_OPERATOR_INFIX_NONE) && (precedence == top->lastNonAssociative)) {
+			retractEvents(ctx, following.pendingMark);
+			success = true;
+			goto done;
+		}
+
+		cut = cut || following.cut;
+		following.offset = SIZE_MAX;
+
+		if(kind == PARSE_OPERATOR_POSTFIX) {
+			offset += following.length;
+			continue;
+		}
+
+		if(!pushFrame(&stack, (OperatorFrame) {
+			.type = OPERATOR_FRAME_INFIX,
+			// Left associative operators end their right operand at the next operator of the same precedence.
+			.minPrecedence = precedence + ((kind == PARSE_OPERATOR_INFIX_RIGHT)? 0 : 1),
+			.lastNonAssociative = -1,
+			.op = following.op,
+			.opStart = offset,
+			.pendingMark = following.pendingMark,
+			.opCut = following.cut
+		})) {
+			goto done;
+		}
+
+		offset += following.length;
+		nextPrefix = 0;
+		expectOperand = true;
+	}
+
+done:
+	if(stack.frames != stack.localFrames) {
+		free(stack.frames);
+	}
+
+	if(!success) {
+		return setParseResultWithCut(result_ret, false, NULL, 0, cut);
+	}
+
+	return setParseResultWithCut(result_ret, true, str, offset, cut);
+}
+
+static const char* OPERATOR_KIND_NAMES[] = {
+	[PARSE_OPERATOR_PREFIX] = "prefix",
+	[PARSE_OPERATOR_POSTFIX] = "postfix",
+	[PARSE_OPERATOR_INFIX_LEFT] = "left",
+	[PARSE_OPERATOR_INFIX_RIGHT] = "right",
+	[PARSE_OPERATOR_INFIX_NONE] = "none"
+};
+
+void OperatorPrecedenceRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+	fprintf(fout, "Operators(");
+	Rule_PrintSimpleRulePointer(Rule_GetOperandRule(rule), fout);
+
+	for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+		fprintf(fout, ", %s %u ", OPERATOR_KIND_NAMES[Rule_GetOperatorKind(rule, i)], Rule_GetOperatorPrecedence(rule, i));
+		Rule_PrintSimpleRulePointer(Rule_GetOperatorRule(rule, i), fout);
+	}
+	fprintf(fout, ")");
+
+	if(depth < maxDepth) {
+		Rule_PrintDeep(Rule_GetOperandRule(rule), fout, depth + 1, maxDepth, indentStr);
+		for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+			Rule_PrintDeep(Rule_GetOperatorRule(rule, i), fout, depth + 1, maxDepth, indentStr);
+		}
+	}
+}
+
+void OperatorPrecedenceRule_Print(ParseRule* rule, FILE* fout) {
+	OperatorPrecedenceRule_PrintDeep(rule, fout, 0, 0, "");
+}
@@ -3,6 +3,7 @@
 #include <stdarg.h>
 #include "ParseFramework.h"
 #include "RulesListRuleUtil.h"
+#include "ParseProfile.h"
 
 
 ParseRule* createOptionListRule(ParseScheme* scheme, ...) {
@@ -20,28 +21,43 @@ ParseRule* createOptionListRule(ParseScheme* scheme, ...) {
 	return ret;
 }
 
-void OptionListRule_Free(OptionListParseRule* rule) {
-	RulesListRuleData_Free(rule);
-}
-
-ParseResult OptionListRule_Parse(OptionListParseRule* rule, char* str, ParseResult* result_ret) {
+ParseResult OptionListRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	if(rule == NULL) {
 		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
-	for(size_t i = 0; i < rule->rulesLen; i++) {
-		ParseResult result; 
-		if(Rule_Parse(rule->rules[i], str, &result).success) {
+	size_t available = (ctx->input + ctx->inputLen) - str;
+
+	for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+		ParseRule* option = Rule_GetListRule(rule, i);
+
+		// Options that need more input than is left are skipped, which depends on where the input ends.
+		if(Rule_CannotMatchWithin(option, available)) {
+			ParseContext_MarkExamined(ctx, ctx->input + ctx->inputLen, 1);
+			continue;
+		}
+
+		ParseResult result;
+		if(Rule_ParseWithContext(option, ctx, str, &result).success) {
+			if(ctx->profile != NULL) {
+				ParseProfile_RecordOption(ctx->profile, rule, i);
+			}
+
 			(*result_ret) = result;
 			return result;
 		}
+
+		// The option committed before failing, so we aren't allowed to try the remaining options.
+		if(result.cut) {
+			return setParseResultWithCut(result_ret, false, NULL, 0, true);
+		}
 	}
 
 	return setParseResult(result_ret, false, NULL, 0);
 }
 
-void OptionListRule_PrintDeep(OptionListParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+void OptionListRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
 	// for(size_t i = 0; i < depth; i++) {
 	// 	fprintf(fout, "%s", indentStr);
 	// }
@@ -50,6 +66,6 @@ void OptionListRule_PrintDeep(OptionListParseRule* rule, FILE* fout, size_t dept
 	RulesListRuleData_PrintDeep(rule, fout, depth, maxDepth, indentStr);
 }
 
-void OptionListRule_Print(OptionListParseRule* rule, FILE* fout) {
+void OptionListRule_Print(ParseRule* rule, FILE* fout) {
 	OptionListRule_PrintDeep(rule, fout, 0, 0, "");
 }
\ No newline at end of file
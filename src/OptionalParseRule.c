@@ -8,58 +8,50 @@ ParseRule* OptionalRule_Create(ParseScheme* scheme, ParseRule* rule) {
 		return NULL;
 	}
 
-	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
-
-	if(ret == NULL) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to create an optional rule around a null rule!\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
 		return NULL;
 	}
 
-	ret->optionalRule = (OptionalParseRule*) malloc(sizeof(OptionalParseRule));
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
 
-	if(ret->optionalRule == NULL) {
-		fprintf(stderr, "Error: unable to allocate optional rule!\n");
-		ParseScheme_Free(scheme);
-		scheme->errorState = 2;
+	if(ret == NULL) {
 		return NULL;
 	}
 
-	ret->optionalRule->rule = rule;
+	ret->optionalRule.rule = Rule_GetIndex(rule);
 
 	ret->ruleType = PARSE_RULE_OPTIONAL;
 
-	return ret;
-}
-
-void OptionalRule_Free(OptionalParseRule* rule) {
-	if(rule == NULL) {
-		return;
-	}
-
-	free(rule);
+	return ParseScheme_InternRule(scheme, ret);
 }
 
-ParseResult OptionalRule_Parse(OptionalParseRule* rule, char* str, ParseResult* result_ret) {
+ParseResult OptionalRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	ParseResult parseRes;
-	if(Rule_Parse(rule->rule, str, &parseRes).success) {
+	if(Rule_ParseWithContext(Rule_GetInnerRule(rule), ctx, str, &parseRes).success) {
 		if(result_ret != NULL) {
 			(*result_ret) = parseRes;
 		}
 		return parseRes;
+	} else if(parseRes.cut) {
+		return setParseResultWithCut(result_ret, false, NULL, 0, true);
 	} else {
 		return setParseResult(result_ret, true, str, 0);
 	}
 }
 
-void OptionalRule_PrintDeep(OptionalParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+void OptionalRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
 	fprintf(fout, "Optional(");
-	Rule_PrintSimpleRulePointer(rule->rule, fout);
+	Rule_PrintSimpleRulePointer(Rule_GetInnerRule(rule), fout);
 	fprintf(fout, ")");
 
 	if(depth < maxDepth) {
-		Rule_PrintDeep(rule->rule, fout, depth + 1, maxDepth, indentStr);
+		Rule_PrintDeep(Rule_GetInnerRule(rule), fout, depth + 1, maxDepth, indentStr);
 	}
 
 }
-void OptionalRule_Print(OptionalParseRule* rule, FILE* fout) {
+void OptionalRule_Print(ParseRule* rule, FILE* fout) {
 	OptionalRule_PrintDeep(rule, fout, 0, 0, "");
 }
\ No newline at end of file
@@ -0,0 +1,995 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "ParseFramework.h"
+#include "RuleAnalysis.h"
+#include "ParseDfa.h"
+
+// Repeats are unrolled, so their bounds have to be small.
+const size_t PARSE_DFA_MAX_UNROLLED_REPS = 64;
+const size_t PARSE_DFA_MAX_NFA_STATES = 8192;
+const size_t PARSE_DFA_MAX_STATES = 4096;
+
+
+// =================================
+// Checking whether a rule is regular
+// =================================
+
+static bool isDeterministic(ParseRule* rule, const ByteSet* follow) {
+	if((rule == NULL) || rule->wasForwardDeclaration) {
+		return false;
+	}
+
+	ByteSet first;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+		case PARSE_RULE_STRING:
+			return true;
+		case PARSE_RULE_SEQUENCE: {
+			// The skipper isn't part of the DFA.
+			if(rule->sequenceRule.skip) {
+				return false;
+			}
+
+			// Walk backwards so that we know what can follow each element.
+			ByteSet elementFollow = (*follow);
+			for(size_t i = rule->sequenceRule.rulesLen; i > 0; i--) {
+				ParseRule* element = Rule_GetListRule(rule, i - 1);
+
+				if(!isDeterministic(element, &elementFollow)) {
+					return false;
+				}
+
+				if(!Rule_GetFirstSet(element, &first)) {
+					ByteSet_Clear(&elementFollow);
+				}
+				ByteSet_Union(&elementFollow, &first);
+			}
+			return true;
+		}
+		case PARSE_RULE_OPTION_LIST: {
+			// Every option has to start with different bytes, so that the next byte picks the option.
+			ByteSet seen;
+			ByteSet_Clear(&seen);
+
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				ParseRule* option = Rule_GetListRule(rule, i);
+				bool nullable = Rule_GetFirstSet(option, &first);
+
+				if(ByteSet_Intersects(&seen, &first)) {
+					return false;
+				}
+				ByteSet_Union(&seen, &first);
+
+				// An option that can match the empty string always succeeds, so it has to be the last one, and
+				// we have to be able to tell from the next byte whether to take it.
+				if(nullable && ((i + 1 < rule->optionListRule.rulesLen) || ByteSet_Intersects(&seen, follow))) {
+					return false;
+				}
+
+				if(!isDeterministic(option, follow)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case PARSE_RULE_OPTIONAL:
+			if(Rule_GetFirstSet(Rule_GetInnerRule(rule), &first) || ByteSet_Intersects(&first, follow)) {
+				return false;
+			}
+			return isDeterministic(Rule_GetInnerRule(rule), follow);
+		case PARSE_RULE_REPEAT: {
+			RepeatParseRule* repeat = &rule->repeatRule;
+
+			// A repeated rule that can match the empty string would never stop.
+			if(Rule_GetFirstSet(Rule_GetInnerRule(rule), &first)) {
+				return false;
+			}
+
+			if((repeat->maxReps > repeat->minReps) && ByteSet_Intersects(&first, follow)) {
+				return false;
+			}
+
+			ByteSet repetitionFollow = (*follow);
+			ByteSet_Union(&repetitionFollow, &first);
+
+			return isDeterministic(Rule_GetInnerRule(rule), &repetitionFollow);
+		}
+		default:
+			return false;
+	}
+}
+
+bool ParseDfa_IsRegular(ParseRule* rule) {
+	// Whatever follows the rule doesn't matter, since the DFA reports the longest match it finds.
+	ByteSet follow;
+	ByteSet_Clear(&follow);
+
+	return isDeterministic(rule, &follow);
+}
+
+
+// =================================
+// Building an NFA
+// =================================
+
+typedef struct {
+	int32_t from;
+	int32_t to;
+	// An index into Nfa.sets, or -1 for an epsilon edge.
+	int32_t setIndex;
+} NfaEdge;
+
+typedef struct {
+	size_t numStates;
+
+	NfaEdge* edges;
+	size_t numEdges;
+	size_t maxEdges;
+
+	ByteSet* sets;
+	size_t numSets;
+	size_t maxSets;
+
+	int32_t* accepts;
+
+	// Filled in by Nfa_Index: the edges leaving each state are edges[edgeStarts[s]] to edges[edgeStarts[s + 1]].
+	size_t* edgeStarts;
+} Nfa;
+
+static int32_t Nfa_AddState(Nfa* nfa) {
+	if(nfa->numStates >= PARSE_DFA_MAX_NFA_STATES) {
+		return -1;
+	}
+	return (int32_t) nfa->numStates++;
+}
+
+static bool Nfa_AddEdge(Nfa* nfa, int32_t from, int32_t to, const ByteSet* set) {
+	if(nfa->numEdges == nfa->maxEdges) {
+		size_t newMax = (nfa->maxEdges == 0)? 64 : nfa->maxEdges * 2;
+		NfaEdge* newEdges = (NfaEdge*) realloc(nfa->edges, sizeof(NfaEdge) * newMax);
+		if(newEdges == NULL) {
+			return false;
+		}
+		nfa->edges = newEdges;
+		nfa->maxEdges = newMax;
+	}
+
+	int32_t setIndex = -1;
+
+	if(set != NULL) {
+		if(nfa->numSets == nfa->maxSets) {
+			size_t newMax = (nfa->maxSets == 0)? 64 : nfa->maxSets * 2;
+			ByteSet* newSets = (ByteSet*) realloc(nfa->sets, sizeof(ByteSet) * newMax);
+			if(newSets == NULL) {
+				return false;
+			}
+			nfa->sets = newSets;
+			nfa->maxSets = newMax;
+		}
+		nfa->sets[nfa->numSets] = (*set);
+		setIndex = (int32_t) nfa->numSets++;
+	}
+
+	nfa->edges[nfa->numEdges++] = (NfaEdge) { .from = from, .to = to, .setIndex = setIndex };
+
+	return true;
+}
+
+static bool buildFragment(Nfa* nfa, ParseRule* rule, int32_t start, int32_t* end_ret);
+
+static bool buildRepeatFragment(Nfa* nfa, ParseRule* repeatRule, int32_t start, int32_t* end_ret) {
+	RepeatParseRule* rule = &repeatRule->repeatRule;
+	ParseRule* innerRule = Rule_GetInnerRule(repeatRule);
+
+	if((rule->minReps > PARSE_DFA_MAX_UNROLLED_REPS)
+		|| ((rule->maxReps != SIZE_MAX) && (rule->maxReps > PARSE_DFA_MAX_UNROLLED_REPS))) {
+		return false;
+	}
+
+	int32_t current = start;
+
+	for(size_t i = 0; i < rule->minReps; i++) {
+		if(!buildFragment(nfa, innerRule, current, &current)) {
+			return false;
+		}
+	}
+
+	if(rule->maxReps == SIZE_MAX) {
+		// The loop needs a state of its own. If it looped back to a state that other rules also start
+		// from, those rules could be entered partway through the repetitions.
+		int32_t loop = Nfa_AddState(nfa);
+		if((loop < 0) || !Nfa_AddEdge(nfa, current, loop, NULL)) {
+			return false;
+		}
+		current = loop;
+	}
+
+	int32_t end = Nfa_AddState(nfa);
+	if((end < 0) || !Nfa_AddEdge(nfa, current, end, NULL)) {
+		return false;
+	}
+
+	if(rule->maxReps == SIZE_MAX) {
+		int32_t loopEnd;
+		if(!buildFragment(nfa, innerRule, current, &loopEnd) || !Nfa_AddEdge(nfa, loopEnd, current, NULL)) {
+			return false;
+		}
+	} else {
+		for(size_t i = rule->minReps; i < rule->maxReps; i++) {
+			if(!buildFragment(nfa, innerRule, current, &current) || !Nfa_AddEdge(nfa, current, end, NULL)) {
+				return false;
+			}
+		}
+	}
+
+	(*end_ret) = end;
+	return true;
+}
+
+// Builds the NFA for a rule, starting from an existing state. The state that the rule ends in is returned
+// through end_ret.
+static bool buildFragment(Nfa* nfa, ParseRule* rule, int32_t start, int32_t* end_ret) {
+	int32_t end;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET: {
+			ByteSet set;
+			ByteSet_Clear(&set);
+			for(size_t i = 0; i < rule->alphabetRule.alphabetLen; i++) {
+				if(rule->alphabetRule.caseInsensitive) {
+					ByteSet_AddBothCases(&set, Rule_GetText(rule)[i]);
+				} else {
+					ByteSet_Add(&set, Rule_GetText(rule)[i]);
+				}
+			}
+
+			end = Nfa_AddState(nfa);
+			if((end < 0) || !Nfa_AddEdge(nfa, start, end, &set)) {
+				return false;
+			}
+			break;
+		}
+		case PARSE_RULE_STRING:
+			end = start;
+			for(size_t i = 0; i < rule->stringRule.stringLen; i++) {
+				ByteSet set;
+				ByteSet_Clear(&set);
+				if(rule->stringRule.caseInsensitive) {
+					ByteSet_AddBothCases(&set, Rule_GetText(rule)[i]);
+				} else {
+					ByteSet_Add(&set, Rule_GetText(rule)[i]);
+				}
+
+				int32_t next = Nfa_AddState(nfa);
+				if((next < 0) || !Nfa_AddEdge(nfa, end, next, &set)) {
+					return false;
+				}
+				end = next;
+			}
+			break;
+		case PARSE_RULE_SEQUENCE:
+			end = start;
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				if(!buildFragment(nfa, Rule_GetListRule(rule, i), end, &end)) {
+					return false;
+				}
+			}
+			break;
+		case PARSE_RULE_OPTION_LIST:
+			end = Nfa_AddState(nfa);
+			if(end < 0) {
+				return false;
+			}
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				int32_t optionEnd;
+				if(!buildFragment(nfa, Rule_GetListRule(rule, i), start, &optionEnd)
+					|| !Nfa_AddEdge(nfa, optionEnd, end, NULL)) {
+					return false;
+				}
+			}
+			break;
+		case PARSE_RULE_OPTIONAL:
+			if(!buildFragment(nfa, Rule_GetInnerRule(rule), start, &end) || !Nfa_AddEdge(nfa, start, end, NULL)) {
+				return false;
+			}
+			break;
+		case PARSE_RULE_REPEAT:
+			if(!buildRepeatFragment(nfa, rule, start, &end)) {
+				return false;
+			}
+			break;
+		default:
+			return false;
+	}
+
+	(*end_ret) = end;
+	return true;
+}
+
+static bool Nfa_Index(Nfa* nfa) {
+	nfa->edgeStarts = (size_t*) calloc(nfa->numStates + 1, sizeof(size_t));
+	size_t* fill = (size_t*) malloc(sizeof(size_t) * (nfa->numStates + 1));
+	NfaEdge* sortedEdges = (NfaEdge*) malloc(sizeof(NfaEdge) * (nfa->numEdges + 1));
+
+	if((nfa->edgeStarts == NULL) || (fill == NULL) || (sortedEdges == NULL)) {
+		free(fill);
+		free(sortedEdges);
+		return false;
+	}
+
+	// Counting sort by source state.
+	for(size_t i = 0; i < nfa->numEdges; i++) {
+		nfa->edgeStarts[nfa->edges[i].from + 1]++;
+	}
+	for(size_t s = 0; s < nfa->numStates; s++) {
+		nfa->edgeStarts[s + 1] += nfa->edgeStarts[s];
+	}
+	memcpy(fill, nfa->edgeStarts, sizeof(size_t) * (nfa->numStates + 1));
+	for(size_t i = 0; i < nfa->numEdges; i++) {
+		sortedEdges[fill[nfa->edges[i].from]++] = nfa->edges[i];
+	}
+
+	free(fill);
+	free(nfa->edges);
+	nfa->edges = sortedEdges;
+
+	return true;
+}
+
+static void Nfa_Free(Nfa* nfa) {
+	free(nfa->edges);
+	free(nfa->sets);
+	free(nfa->accepts);
+	free(nfa->edgeStarts);
+}
+
+
+// =================================
+// Interning lists of integers
+// =================================
+
+// Both the subset construction and minimization need to give ids to lists of integers.
+typedef struct {
+	int32_t* data;
+	size_t dataLen;
+	size_t maxDataLen;
+
+	size_t* starts;
+	size_t* lengths;
+	size_t count;
+	size_t maxCount;
+
+	int32_t* slots;
+	size_t numSlots;
+} IntListTable;
+
+static uint64_t hashIntList(const int32_t* list, size_t len) {
+	uint64_t hash = 14695981039346656037ULL;
+	for(size_t i = 0; i < len; i++) {
+		hash = (hash ^ (uint32_t) list[i]) * 1099511628211ULL;
+	}
+	return hash ^ len;
+}
+
+static bool IntListTable_Grow(IntListTable* table) {
+	size_t newNumSlots = (table->numSlots == 0)? 256 : table->numSlots * 2;
+	int32_t* newSlots = (int32_t*) malloc(sizeof(int32_t) * newNumSlots);
+	size_t newMaxCount = newNumSlots / 2;
+	size_t* newStarts = (size_t*) realloc(table->starts, sizeof(size_t) * newMaxCount);
+	if(newStarts != NULL) {
+		table->starts = newStarts;
+	}
+	size_t* newLengths = (size_t*) realloc(table->lengths, sizeof(size_t) * newMaxCount);
+	if(newLengths != NULL) {
+		table->lengths = newLengths;
+	}
+
+	if((newSlots == NULL) || (newStarts == NULL) || (newLengths == NULL)) {
+		free(newSlots);
+		return false;
+	}
+
+	for(size_t i = 0; i < newNumSlots; i++) {
+		newSlots[i] = -1;
+	}
+	for(size_t id = 0; id < table->count; id++) {
+		uint64_t slot = hashIntList(table->data + table->starts[id], table->lengths[id]) & (newNumSlots - 1);
+		while(newSlots[slot] != -1) {
+			slot = (slot + 1) & (newNumSlots - 1);
+		}
+		newSlots[slot] = (int32_t) id;
+	}
+
+	free(table->slots);
+	table->slots = newSlots;
+	table->numSlots = newNumSlots;
+	table->maxCount = newMaxCount;
+
+	return true;
+}
+
+// Returns the list's id, or -1 if we ran out of memory.
+static int32_t IntListTable_Intern(IntListTable* table, const int32_t* list, size_t len, bool* added_ret) {
+	(*added_ret) = false;
+
+	if((table->count == table->maxCount) && !IntListTable_Grow(table)) {
+		return -1;
+	}
+
+	uint64_t slot = hashIntList(list, len) & (table->numSlots - 1);
+
+	while(table->slots[slot] != -1) {
+		int32_t id = table->slots[slot];
+		if((table->lengths[id] == len) && (memcmp(table->data + table->starts[id], list, sizeof(int32_t) * len) == 0)) {
+			return id;
+		}
+		slot = (slot + 1) & (table->numSlots - 1);
+	}
+
+	if(table->dataLen + len > table->maxDataLen) {
+		size_t newMax = (table->maxDataLen == 0)? 1024 : table->maxDataLen * 2;
+		while(table->dataLen + len > newMax) {
+			newMax *= 2;
+		}
+		int32_t* newData = (int32_t*) realloc(table->data, sizeof(int32_t) * newMax);
+		if(newData == NULL) {
+			return -1;
+		}
+		table->data = newData;
+		table->maxDataLen = newMax;
+	}
+
+	int32_t id = (int32_t) table->count++;
+	table->starts[id] = table->dataLen;
+	table->lengths[id] = len;
+	memcpy(table->data + table->dataLen, list, sizeof(int32_t) * len);
+	table->dataLen += len;
+	table->slots[slot] = id;
+
+	(*added_ret) = true;
+	return id;
+}
+
+static void IntListTable_Free(IntListTable* table) {
+	free(table->data);
+	free(table->starts);
+	free(table->lengths);
+	free(table->slots);
+}
+
+
+// =================================
+// Building the DFA
+// =================================
+
+static int compareInt32(const void* a, const void* b) {
+	int32_t x = *((const int32_t*) a);
+	int32_t y = *((const int32_t*) b);
+	return (x > y) - (x < y);
+}
+
+// Adds every state reachable through epsilon edges to the set, then sorts it.
+static void epsilonClose(Nfa* nfa, int32_t* set, size_t* len, bool* inSet) {
+	for(size_t i = 0; i < (*len); i++) {
+		int32_t s = set[i];
+		for(size_t e = nfa->edgeStarts[s]; e < nfa->edgeStarts[s + 1]; e++) {
+			NfaEdge* edge = nfa->edges + e;
+			if((edge->setIndex == -1) && !inSet[edge->to]) {
+				inSet[edge->to] = true;
+				set[(*len)++] = edge->to;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < (*len); i++) {
+		inSet[set[i]] = false;
+	}
+
+	qsort(set, *len, sizeof(int32_t), compareInt32);
+}
+
+// Splits the bytes into classes that every edge in the NFA treats the same.
+static void computeByteClasses(Nfa* nfa, ParseDfa* dfa) {
+	// While splitting, ids can temporarily go past 255.
+	int classes[256] = {0};
+	size_t numClasses = 1;
+
+	for(size_t i = 0; i < nfa->numSets; i++) {
+		// Bytes of class c that are in the set move to class splitInto[c].
+		int splitInto[512];
+		for(size_t c = 0; c < numClasses; c++) {
+			splitInto[c] = -1;
+		}
+
+		size_t numSplitClasses = numClasses;
+		for(size_t b = 0; b < 256; b++) {
+			if(!ByteSet_Contains(nfa->sets + i, (unsigned char) b)) {
+				continue;
+			}
+			int c = classes[b];
+			if(splitInto[c] == -1) {
+				splitInto[c] = (int) numSplitClasses++;
+			}
+			classes[b] = splitInto[c];
+		}
+
+		// A class that moved over entirely didn't need to be split, so renumber to keep the ids dense.
+		bool used[512] = {false};
+		for(size_t b = 0; b < 256; b++) {
+			used[classes[b]] = true;
+		}
+		int renumber[512];
+		numClasses = 0;
+		for(size_t c = 0; c < numSplitClasses; c++) {
+			renumber[c] = used[c]? (int) numClasses++ : -1;
+		}
+		for(size_t b = 0; b < 256; b++) {
+			classes[b] = renumber[classes[b]];
+		}
+	}
+
+	for(size_t b = 0; b < 256; b++) {
+		dfa->byteClasses[b] = (uint8_t) classes[b];
+	}
+	dfa->numClasses = numClasses;
+}
+
+static bool buildSubsetDfa(Nfa* nfa, int32_t nfaStart, ParseDfa* dfa) {
+	IntListTable table = {0};
+	int32_t* set = (int32_t*) malloc(sizeof(int32_t) * nfa->numStates);
+	bool* inSet = (bool*) calloc(nfa->numStates, sizeof(bool));
+	size_t maxStates = 0;
+	bool ok = (set != NULL) && (inSet != NULL);
+
+	uint8_t representatives[256];
+	for(size_t b = 256; b > 0; b--) {
+		representatives[dfa->byteClasses[b - 1]] = (uint8_t) (b - 1);
+	}
+
+	size_t setLen = 1;
+	bool added;
+	if(ok) {
+		set[0] = nfaStart;
+		inSet[nfaStart] = true;
+		epsilonClose(nfa, set, &setLen, inSet);
+		dfa->startState = IntListTable_Intern(&table, set, setLen, &added);
+		ok = (dfa->startState == 0);
+	}
+
+	// The table hands out ids in order, so the states still to process are exactly the ids we haven't
+	// reached yet.
+	for(size_t state = 0; ok && (state < table.count); state++) {
+		if(table.count > PARSE_DFA_MAX_STATES) {
+			ok = false;
+			break;
+		}
+
+		if(state >= maxStates) {
+			maxStates = (maxStates == 0)? 64 : maxStates * 2;
+			int32_t* newTransitions = (int32_t*) realloc(dfa->transitions, sizeof(int32_t) * maxStates * dfa->numClasses);
+			if(newTransitions != NULL) {
+				dfa->transitions = newTransitions;
+			}
+			int32_t* newAccepts = (int32_t*) realloc(dfa->accepts, sizeof(int32_t) * maxStates);
+			if(newAccepts != NULL) {
+				dfa->accepts = newAccepts;
+			}
+			uint64_t* newAcceptMasks = (uint64_t*) realloc(dfa->acceptMasks, sizeof(uint64_t) * maxStates);
+			if(newAcceptMasks != NULL) {
+				dfa->acceptMasks = newAcceptMasks;
+			}
+			if((newTransitions == NULL) || (newAccepts == NULL) || (newAcceptMasks == NULL)) {
+				ok = false;
+				break;
+			}
+		}
+
+		dfa->accepts[state] = -1;
+		dfa->acceptMasks[state] = 0;
+		for(size_t i = 0; i < table.lengths[state]; i++) {
+			int32_t tag = nfa->accepts[table.data[table.starts[state] + i]];
+			if(tag == -1) {
+				continue;
+			}
+			if((dfa->accepts[state] == -1) || (tag < dfa->accepts[state])) {
+				dfa->accepts[state] = tag;
+			}
+			if(tag < 64) {
+				dfa->acceptMasks[state] |= ((uint64_t) 1) << tag;
+			}
+		}
+
+		for(size_t c = 0; c < dfa->numClasses; c++) {
+			setLen = 0;
+			for(size_t i = 0; i < table.lengths[state]; i++) {
+				int32_t s = table.data[table.starts[state] + i];
+				for(size_t e = nfa->edgeStarts[s]; e < nfa->edgeStarts[s + 1]; e++) {
+					NfaEdge* edge = nfa->edges + e;
+					if((edge->setIndex != -1) && !inSet[edge->to]
+						&& ByteSet_Contains(nfa->sets + edge->setIndex, representatives[c])) {
+						inSet[edge->to] = true;
+						set[setLen++] = edge->to;
+					}
+				}
+			}
+
+			if(setLen == 0) {
+				dfa->transitions[state * dfa->numClasses + c] = -1;
+				continue;
+			}
+
+			epsilonClose(nfa, set, &setLen, inSet);
+			int32_t next = IntListTable_Intern(&table, set, setLen, &added);
+			if(next < 0) {
+				ok = false;
+				break;
+			}
+			dfa->transitions[state * dfa->numClasses + c] = next;
+		}
+	}
+
+	dfa->numStates = table.count;
+
+	free(set);
+	free(inSet);
+	IntListTable_Free(&table);
+
+	return ok;
+}
+
+// Works out which rules can still match from each state, and removes the states that can't lead to a match
+// at all, so that matching stops as soon as possible.
+static bool pruneDeadStates(ParseDfa* dfa) {
+	bool* live = (bool*) calloc(dfa->numStates, sizeof(bool));
+	dfa->liveMasks = (uint64_t*) malloc(sizeof(uint64_t) * dfa->numStates);
+
+	if((live == NULL) || (dfa->liveMasks == NULL)) {
+		free(live);
+		return false;
+	}
+
+	for(size_t s = 0; s < dfa->numStates; s++) {
+		live[s] = (dfa->accepts[s] != -1);
+		dfa->liveMasks[s] = dfa->acceptMasks[s];
+	}
+
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(size_t s = 0; s < dfa->numStates; s++) {
+			for(size_t c = 0; c < dfa->numClasses; c++) {
+				int32_t next = dfa->transitions[s * dfa->numClasses + c];
+				if(next == -1) {
+					continue;
+				}
+				if(live[next] && !live[s]) {
+					live[s] = true;
+					changed = true;
+				}
+				if((dfa->liveMasks[next] | dfa->liveMasks[s]) != dfa->liveMasks[s]) {
+					dfa->liveMasks[s] |= dfa->liveMasks[next];
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for(size_t i = 0; i < dfa->numStates * dfa->numClasses; i++) {
+		if((dfa->transitions[i] != -1) && !live[dfa->transitions[i]]) {
+			dfa->transitions[i] = -1;
+		}
+	}
+
+	free(live);
+	return true;
+}
+
+// Merges equivalent states with Moore's partition refinement.
+static bool minimize(ParseDfa* dfa) {
+	size_t n = dfa->numStates;
+	size_t k = dfa->numClasses;
+	int32_t* block = (int32_t*) malloc(sizeof(int32_t) * n);
+	int32_t* newBlock = (int32_t*) malloc(sizeof(int32_t) * n);
+	int32_t* signature = (int32_t*) malloc(sizeof(int32_t) * (k + 4));
+
+	if((block == NULL) || (newBlock == NULL) || (signature == NULL)) {
+		free(block);
+		free(newBlock);
+		free(signature);
+		return false;
+	}
+
+	for(size_t s = 0; s < n; s++) {
+		block[s] = 0;
+	}
+
+	size_t numBlocks = 0;
+	bool ok = true;
+
+	while(true) {
+		IntListTable table = {0};
+		bool added;
+
+		// States stay in the same block as long as they accept the same way, were in the same block last
+		// round, and lead to the same blocks. Each round refines the last, so we stop once nothing splits.
+		for(size_t s = 0; s < n; s++) {
+			signature[0] = dfa->accepts[s];
+			signature[1] = (int32_t) (dfa->acceptMasks[s] & 0xFFFFFFFF);
+			signature[2] = (int32_t) (dfa->acceptMasks[s] >> 32);
+			signature[3] = block[s];
+			for(size_t c = 0; c < k; c++) {
+				int32_t next = dfa->transitions[s * k + c];
+				signature[c + 4] = (next == -1)? -1 : block[next];
+			}
+
+			newBlock[s] = IntListTable_Intern(&table, signature, k + 4, &added);
+			if(newBlock[s] < 0) {
+				ok = false;
+				break;
+			}
+		}
+
+		size_t newNumBlocks = table.count;
+		IntListTable_Free(&table);
+
+		if(!ok) {
+			break;
+		}
+
+		memcpy(block, newBlock, sizeof(int32_t) * n);
+
+		if(newNumBlocks == numBlocks) {
+			break;
+		}
+		numBlocks = newNumBlocks;
+	}
+
+	int32_t* transitions = NULL;
+	int32_t* accepts = NULL;
+	uint64_t* acceptMasks = NULL;
+	uint64_t* liveMasks = NULL;
+
+	if(ok) {
+		transitions = (int32_t*) malloc(sizeof(int32_t) * numBlocks * k);
+		accepts = (int32_t*) malloc(sizeof(int32_t) * numBlocks);
+		acceptMasks = (uint64_t*) malloc(sizeof(uint64_t) * numBlocks);
+		liveMasks = (uint64_t*) malloc(sizeof(uint64_t) * numBlocks);
+		ok = (transitions != NULL) && (accepts != NULL) && (acceptMasks != NULL) && (liveMasks != NULL);
+	}
+
+	if(ok) {
+		// Equivalent states match the same way, so it doesn't matter which one of them we copy from.
+		for(size_t s = 0; s < n; s++) {
+			int32_t b = block[s];
+			accepts[b] = dfa->accepts[s];
+			acceptMasks[b] = dfa->acceptMasks[s];
+			liveMasks[b] = dfa->liveMasks[s];
+			for(size_t c = 0; c < k; c++) {
+				int32_t next = dfa->transitions[s * k + c];
+				transitions[b * k + c] = (next == -1)? -1 : block[next];
+			}
+		}
+
+		free(dfa->transitions);
+		free(dfa->accepts);
+		free(dfa->acceptMasks);
+		free(dfa->liveMasks);
+		dfa->transitions = transitions;
+		dfa->accepts = accepts;
+		dfa->acceptMasks = acceptMasks;
+		dfa->liveMasks = liveMasks;
+		dfa->startState = block[dfa->startState];
+		dfa->numStates = numBlocks;
+	} else {
+		free(transitions);
+		free(accepts);
+		free(acceptMasks);
+		free(liveMasks);
+	}
+
+	free(block);
+	free(newBlock);
+	free(signature);
+
+	return ok;
+}
+
+static ParseDfa* compile(ParseRule** rules, size_t numRules, bool firstMatchWins) {
+	for(size_t i = 0; i < numRules; i++) {
+		if(!ParseDfa_IsRegular(rules[i])) {
+			return NULL;
+		}
+	}
+
+	ParseDfa* dfa = (ParseDfa*) calloc(1, sizeof(ParseDfa));
+	Nfa nfa = {0};
+
+	if(dfa == NULL) {
+		fprintf(stderr, "Error: unable to allocate DFA!\n");
+		return NULL;
+	}
+
+	dfa->firstMatchWins = firstMatchWins;
+
+	int32_t start = Nfa_AddState(&nfa);
+	bool ok = true;
+
+	// Every rule gets its own branch off of the start state, and its end state accepts with its index.
+	int32_t* ends = (int32_t*) malloc(sizeof(int32_t) * (numRules + 1));
+	ok = (ends != NULL);
+
+	for(size_t i = 0; ok && (i < numRules); i++) {
+		int32_t ruleStart = Nfa_AddState(&nfa);
+		ok = (ruleStart >= 0) && Nfa_AddEdge(&nfa, start, ruleStart, NULL)
+			&& buildFragment(&nfa, rules[i], ruleStart, ends + i);
+	}
+
+	if(ok) {
+		nfa.accepts = (int32_t*) malloc(sizeof(int32_t) * nfa.numStates);
+		ok = (nfa.accepts != NULL) && Nfa_Index(&nfa);
+	}
+
+	if(ok) {
+		for(size_t s = 0; s < nfa.numStates; s++) {
+			nfa.accepts[s] = -1;
+		}
+		// Go backwards so that the earliest rule wins if two rules share an end state.
+		for(size_t i = numRules; i > 0; i--) {
+			nfa.accepts[ends[i - 1]] = (int32_t) (i - 1);
+		}
+
+		computeByteClasses(&nfa, dfa);
+		ok = buildSubsetDfa(&nfa, start, dfa);
+	}
+
+	if(ok) {
+		ok = pruneDeadStates(dfa) && minimize(dfa);
+	}
+
+	free(ends);
+	Nfa_Free(&nfa);
+
+	if(!ok) {
+		ParseDfa_Free(dfa);
+		return NULL;
+	}
+
+	return dfa;
+}
+
+ParseDfa* ParseDfa_Compile(ParseRule** rules, size_t numRules) {
+	return compile(rules, numRules, false);
+}
+
+ParseDfa* ParseDfa_CompileOptions(ParseRule** rules, size_t numRules) {
+	if(numRules > 64) {
+		return NULL;
+	}
+	return compile(rules, numRules, true);
+}
+
+void ParseDfa_Free(ParseDfa* dfa) {
+	if(dfa == NULL) {
+		return;
+	}
+
+	free(dfa->transitions);
+	dfa->transitions = NULL;
+	free(dfa->accepts);
+	dfa->accepts = NULL;
+	free(dfa->acceptMasks);
+	dfa->acceptMasks = NULL;
+	free(dfa->liveMasks);
+	dfa->liveMasks = NULL;
+	free(dfa);
+}
+
+size_t ParseDfa_MemoryUsage(const ParseDfa* dfa) {
+	if(dfa == NULL) {
+		return 0;
+	}
+
+	return sizeof(ParseDfa)
+		+ dfa->numStates * dfa->numClasses * sizeof(int32_t)
+		+ dfa->numStates * (sizeof(int32_t) + 2 * sizeof(uint64_t));
+}
+
+// Finds the first rule that matches, and how much it matches. Each rule's match ends at the last offset where
+// it was accepting, so we have to keep going until no rule before the current best one can still match.
+static bool matchFirst(const ParseDfa* dfa, const char* str, size_t len, size_t* length_ret, int* tag_ret, size_t* examined_ret) {
+	int32_t state = dfa->startState;
+	int matchTag = -1;
+	size_t matchLength = 0;
+	size_t examined;
+
+	for(size_t i = 0; ; i++) {
+		uint64_t acceptMask = dfa->acceptMasks[state];
+		if(acceptMask != 0) {
+			int tag = __builtin_ctzll(acceptMask);
+			if((matchTag == -1) || (tag <= matchTag)) {
+				matchTag = tag;
+				matchLength = i;
+			}
+		}
+
+		// The mask of every rule that could take over from (or extend) the current best match.
+		uint64_t betterMask = (matchTag == -1)? ~((uint64_t) 0) : (((uint64_t) 2) << matchTag) - 1;
+		if(i == len) {
+			// Finding the end of the input counts as looking past it.
+			examined = len + 1;
+			break;
+		}
+		if((dfa->liveMasks[state] & betterMask) == 0) {
+			examined = i;
+			break;
+		}
+
+		state = dfa->transitions[state * dfa->numClasses + dfa->byteClasses[(unsigned char) str[i]]];
+
+		if(state == -1) {
+			examined = i + 1;
+			break;
+		}
+	}
+
+	if(length_ret != NULL) {
+		(*length_ret) = matchLength;
+	}
+	if(tag_ret != NULL) {
+		(*tag_ret) = matchTag;
+	}
+	if(examined_ret != NULL) {
+		(*examined_ret) = examined;
+	}
+
+	return (matchTag != -1);
+}
+
+bool ParseDfa_Match(const ParseDfa* dfa, const char* str, size_t len, size_t* length_ret, int* tag_ret, size_t* examined_ret) {
+	if(dfa->firstMatchWins) {
+		return matchFirst(dfa, str, len, length_ret, tag_ret, examined_ret);
+	}
+
+	int32_t state = dfa->startState;
+	bool matched = false;
+	size_t matchLength = 0;
+	int matchTag = -1;
+
+	if(dfa->accepts[state] != -1) {
+		matched = true;
+		matchTag = dfa->accepts[state];
+	}
+
+	size_t examined = len + 1;
+
+	for(size_t i = 0; i < len; i++) {
+		state = dfa->transitions[state * dfa->numClasses + dfa->byteClasses[(unsigned char) str[i]]];
+
+		if(state == -1) {
+			examined = i + 1;
+			break;
+		}
+
+		if(dfa->accepts[state] != -1) {
+			matched = true;
+			matchLength = i + 1;
+			matchTag = dfa->accepts[state];
+		}
+	}
+
+	if(length_ret != NULL) {
+		(*length_ret) = matchLength;
+	}
+	if(tag_ret != NULL) {
+		(*tag_ret) = matchTag;
+	}
+	if(examined_ret != NULL) {
+		(*examined_ret) = examined;
+	}
+
+	return matched;
+}
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+
+const size_t PARSE_EVENTS_BUFFER_LENGTH = 64;
+
+ParseEvents* ParseEvents_Create(ParseScheme* scheme) {
+	if(scheme == NULL) {
+		fprintf(stderr, "Error: attempting to create events for a null scheme.\n");
+		return NULL;
+	}
+
+	ParseEvents* ret = (ParseEvents*) malloc(sizeof(ParseEvents));
+	ParseEventHandler* handlers = (ParseEventHandler*) calloc(scheme->numRules + 1, sizeof(ParseEventHandler));
+	bool* containsHandled = (bool*) calloc(scheme->numRules + 1, sizeof(bool));
+	ParseEvent* pending = (ParseEvent*) malloc(sizeof(ParseEvent) * PARSE_EVENTS_BUFFER_LENGTH);
+
+	if((ret == NULL) || (handlers == NULL) || (containsHandled == NULL) || (pending == NULL)) {
+		fprintf(stderr, "Error: unable to allocate parse events!\n");
+		free(ret);
+		free(handlers);
+		free(containsHandled);
+		free(pending);
+		return NULL;
+	}
+
+	(*ret) = (ParseEvents) {
+		.scheme = scheme,
+		.handlers = handlers,
+		.numRules = scheme->numRules,
+		.containsHandled = containsHandled,
+		.containsHandledIsValid = true,
+		.pending = pending,
+		.numPending = 0,
+		.maxPending = PARSE_EVENTS_BUFFER_LENGTH,
+		.numUnsafeOpen = 0,
+		.errorState = 0
+	};
+
+	return ret;
+}
+
+void ParseEvents_Free(ParseEvents* events) {
+	if(events == NULL) {
+		return;
+	}
+
+	free(events->handlers);
+	free(events->containsHandled);
+	free(events->pending);
+	free(events);
+}
+
+bool ParseEvents_Select(ParseEvents* events, ParseRule* rule, ParseEventCallback callback, void* userData) {
+	if((events == NULL) || (rule == NULL)) {
+		fprintf(stderr, "Error: attempting to select a null rule or to select for null events.\n");
+		return false;
+	}
+
+	uint32_t index = Rule_GetIndex(rule);
+
+	if((rule->scheme != events->scheme) || (index >= events->numRules)) {
+		fprintf(stderr, "Error: only rules that existed when the events were created can be selected.\n");
+		events->errorState = 4;
+		return false;
+	}
+
+	events->handlers[index] = (ParseEventHandler) {
+		.callback = callback,
+		.userData = userData
+	};
+	events->containsHandledIsValid = false;
+
+	return true;
+}
+
+static bool childContainsHandled(ParseEvents* events, ParseRule* rule) {
+	switch(rule->ruleType) {
+		case PARSE_RULE_SEQUENCE:
+		case PARSE_RULE_OPTION_LIST:
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				if(events->containsHandled[Rule_GetIndex(Rule_GetListRule(rule, i))]) {
+					return true;
+				}
+			}
+			return false;
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT:
+			return events->containsHandled[Rule_GetIndex(Rule_GetInnerRule(rule))];
+		case PARSE_RULE_OPERATOR_PRECEDENCE:
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				if(events->containsHandled[Rule_GetIndex(Rule_GetOperatorRule(rule, i))]) {
+					return true;
+				}
+			}
+			return events->containsHandled[rule->operatorRule.operand];
+		case PARSE_RULE_SEPARATED_LIST:
+			return events->containsHandled[rule->separatedListRule.item] || events->containsHandled[rule->separatedListRule.separator];
+		default:
+			return false;
+	}
+}
+
+// Grammars can be recursive, so this goes over every rule until nothing changes.
+static void findContainsHandled(ParseEvents* events) {
+	for(size_t i = 0; i < events->numRules; i++) {
+		events->containsHandled[i] = (events->handlers[i].callback != NULL);
+	}
+
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(size_t i = 0; i < events->numRules; i++) {
+			if(!events->containsHandled[i] && childContainsHandled(events, events->scheme->rules + i)) {
+				events->containsHandled[i] = true;
+				changed = true;
+			}
+		}
+	}
+
+	events->containsHandledIsValid = true;
+}
+
+bool ParseEvents_NeedsChildren(ParseEvents* events, ParseRule* rule) {
+	if((rule->scheme != events->scheme) || (Rule_GetIndex(rule) >= events->numRules)) {
+		return true;
+	}
+
+	if(!events->containsHandledIsValid) {
+		findContainsHandled(events);
+	}
+
+	return childContainsHandled(events, rule);
+}
+
+// Whether the rule can fail after one of the rules inside it matched, without the whole parse failing.
+static bool isUnsafeRule(ParseRule* rule) {
+	switch(rule->ruleType) {
+		case PARSE_RULE_OPTION_LIST:
+		case PARSE_RULE_OPTIONAL:
+			return false;
+		case PARSE_RULE_REPEAT:
+			return rule->repeatRule.minReps > 1;
+		default:
+			return true;
+	}
+}
+
+static ParseEventHandler* getHandler(ParseEvents* events, ParseRule* rule) {
+	uint32_t index = Rule_GetIndex(rule);
+
+	if((rule->scheme != events->scheme) || (index >= events->numRules) || (events->handlers[index].callback == NULL)) {
+		return NULL;
+	}
+
+	return &events->handlers[index];
+}
+
+static bool addPendingEvent(ParseEvents* events, ParseRule* rule, ParseEventType type, size_t offset, size_t length) {
+	if(events->numPending == events->maxPending) {
+		size_t newLength = events->maxPending * 2;
+		ParseEvent* newPending = (ParseEvent*) realloc(events->pending, sizeof(ParseEvent) * newLength);
+
+		if(newPending == NULL) {
+			fprintf(stderr, "Error: unable to allocate space for pending parse events!\n");
+			events->errorState = 2;
+			return false;
+		}
+
+		events->pending = newPending;
+		events->maxPending = newLength;
+	}
+
+	events->pending[events->numPending++] = (ParseEvent) {
+		.ruleIndex = Rule_GetIndex(rule),
+		.type = type,
+		.offset = offset,
+		.length = length
+	};
+
+	return true;
+}
+
+size_t ParseEvents_Enter(ParseEvents* events, ParseRule* rule, size_t offset, bool* ok_ret) {
+	size_t pendingMark = events->numPending;
+
+	if(isUnsafeRule(rule)) {
+		events->numUnsafeOpen++;
+	}
+
+	(*ok_ret) = (getHandler(events, rule) == NULL) || addPendingEvent(events, rule, PARSE_EVENT_ENTER, offset, 0);
+
+	return pendingMark;
+}
+
+bool ParseEvents_Exit(ParseEvents* events, ParseRule* rule, size_t offset, ParseResult* result, size_t pendingMark) {
+	if(isUnsafeRule(rule)) {
+		events->numUnsafeOpen--;
+	}
+
+	if(!result->success) {
+		// Everything since the rule started was part of an attempt that didn't work out. Events before a flush
+		// aren't dropped, since they are already certain.
+		if(pendingMark < events->numPending) {
+			events->numPending = pendingMark;
+		}
+		return true;
+	}
+
+	if((getHandler(events, rule) != NULL) && !addPendingEvent(events, rule, PARSE_EVENT_EXIT, offset, result->length)) {
+		return false;
+	}
+
+	if(events->numUnsafeOpen == 0) {
+		return ParseEvents_Flush(events);
+	}
+
+	return true;
+}
+
+void ParseEvents_Retract(ParseEvents* events, size_t pendingMark) {
+	// Events before a flush aren't dropped, since they are already certain.
+	if(pendingMark < events->numPending) {
+		events->numPending = pendingMark;
+	}
+}
+
+bool ParseEvents_Flush(ParseEvents* events) {
+	size_t numPending = events->numPending;
+
+	// The callbacks could start another parse with these events, so the buffer is emptied first.
+	events->numPending = 0;
+
+	for(size_t i = 0; i < numPending; i++) {
+		ParseEvent* event = &events->pending[i];
+		ParseEventHandler* handler = &events->handlers[event->ruleIndex];
+
+		if(!handler->callback(events->scheme->rules + event->ruleIndex, event->type, event->offset, event->length, handler->userData)) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,750 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseDfa.h"
+#include "RepeatParseRule.h"
+#include "ParseLint.h"
+#include "RuleLengths.h"
+#include "ParseFinalize.h"
+
+typedef struct {
+	ParseScheme* scheme;
+
+	// Indexed like the scheme's rules before finalizing. A forward rule's canonical rule is the one it was
+	// given as its value, every other rule is its own.
+	uint32_t* canonical;
+	// Where each rule ends up, or UINT32_MAX if it is dropped.
+	uint32_t* newIndices;
+	size_t numLive;
+
+	// Rules waiting to be numbered.
+	uint32_t* stack;
+	size_t stackLen;
+	size_t maxStack;
+
+	// Set once the new rules exist, for mapping custom rules' references.
+	ParseRule* newRules;
+} Relayout;
+
+// ForwardRule_SetValue copies the value into the forward rule, so the value is the rule that isn't a forward
+// rule and has the same data. Rules with the same data behave the same, so if there are several, any will do.
+static bool hasSameData(ParseRule* a, ParseRule* b) {
+	if(a->ruleType != b->ruleType) {
+		return false;
+	}
+
+	switch(a->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			return (a->alphabetRule.alphabet == b->alphabetRule.alphabet)
+				&& (a->alphabetRule.alphabetLen == b->alphabetRule.alphabetLen)
+				&& (a->alphabetRule.caseInsensitive == b->alphabetRule.caseInsensitive);
+		case PARSE_RULE_STRING:
+			return (a->stringRule.string == b->stringRule.string)
+				&& (a->stringRule.stringLen == b->stringRule.stringLen)
+				&& (a->stringRule.caseInsensitive == b->stringRule.caseInsensitive);
+		case PARSE_RULE_SEQUENCE:
+		case PARSE_RULE_OPTION_LIST:
+			return (a->sequenceRule.firstRule == b->sequenceRule.firstRule)
+				&& (a->sequenceRule.rulesLen == b->sequenceRule.rulesLen)
+				&& (a->sequenceRule.skip == b->sequenceRule.skip);
+		case PARSE_RULE_OPTIONAL:
+			return a->optionalRule.rule == b->optionalRule.rule;
+		case PARSE_RULE_REPEAT:
+			return (a->repeatRule.rule == b->repeatRule.rule)
+				&& (a->repeatRule.minReps == b->repeatRule.minReps)
+				&& (a->repeatRule.maxReps == b->repeatRule.maxReps);
+		case PARSE_RULE_TOKEN:
+			return a->tokenRule.tokenType == b->tokenRule.tokenType;
+		case PARSE_RULE_LAZY:
+			return (a->lazyRule.rule == b->lazyRule.rule) && (a->lazyRule.skipRule == b->lazyRule.skipRule)
+				&& (a->lazyRule.open == b->lazyRule.open) && (a->lazyRule.close == b->lazyRule.close)
+				&& (a->lazyRule.quote == b->lazyRule.quote) && (a->lazyRule.escape == b->lazyRule.escape);
+		case PARSE_RULE_OPERATOR_PRECEDENCE:
+			return (a->operatorRule.operand == b->operatorRule.operand)
+				&& (a->operatorRule.firstOperator == b->operatorRule.firstOperator)
+				&& (a->operatorRule.numOperators == b->operatorRule.numOperators)
+				&& (a->operatorRule.operatorInfo == b->operatorRule.operatorInfo);
+		case PARSE_RULE_SEPARATED_LIST:
+			return (a->separatedListRule.item == b->separatedListRule.item)
+				&& (a->separatedListRule.separator == b->separatedListRule.separator)
+				&& (a->separatedListRule.minItems == b->separatedListRule.minItems)
+				&& (a->separatedListRule.maxItems == b->separatedListRule.maxItems)
+				&& (a->separatedListRule.allowTrailing == b->separatedListRule.allowTrailing);
+		case PARSE_RULE_SCAN_UNTIL:
+			return (a->scanUntilRule.stops == b->scanUntilRule.stops)
+				&& (a->scanUntilRule.numStops == b->scanUntilRule.numStops)
+				&& (a->scanUntilRule.escape == b->scanUntilRule.escape)
+				&& (a->scanUntilRule.required == b->scanUntilRule.required);
+		case PARSE_RULE_CUT:
+		case PARSE_RULE_SKIP:
+			return true;
+		default:
+			return a->customRule.data == b->customRule.data;
+	}
+}
+
+// =================================
+// Tail recursion
+// =================================
+
+// A forward rule that only calls itself last is a loop: rule = head (sep head)*, with at least minReps
+// repetitions of head. Without sep, that is just head repeated.
+typedef struct {
+	uint32_t* head;
+	size_t headLen;
+	uint32_t* sep;
+	size_t sepLen;
+	size_t minReps;
+} TailLoop;
+
+// Whether the rule is the forward rule, or the value it was given.
+static bool isForwardRule(ParseScheme* scheme, uint32_t index, uint32_t forwardIndex) {
+	ParseRule* rule = scheme->rules + index;
+	return (index == forwardIndex) || (!rule->wasForwardDeclaration && hasSameData(rule, scheme->rules + forwardIndex));
+}
+
+// Skip sequences are left alone, since they skip in front of the recursion even when it doesn't match.
+static bool isPlainSequence(ParseRule* rule, size_t minLen) {
+	return (rule->ruleType == PARSE_RULE_SEQUENCE) && !rule->sequenceRule.skip && (rule->sequenceRule.rulesLen >= minLen);
+}
+
+// Whether the rule matches the same thing as the elements of a sequence.
+static bool isSameSequence(ParseScheme* scheme, uint32_t index, uint32_t* elements, size_t len) {
+	ParseRule* rule = scheme->rules + index;
+
+	if(len == 1) {
+		return index == elements[0];
+	}
+	if(!isPlainSequence(rule, len) || (rule->sequenceRule.rulesLen != len)) {
+		return false;
+	}
+	return memcmp(scheme->childIndices + rule->sequenceRule.firstRule, elements, sizeof(uint32_t) * len) == 0;
+}
+
+// Recognizes these, where F is the forward rule:
+//     F = X.. Optional(F)              F = X+
+//     F = X.. Optional(Y.. F)          F = X.. (Y.. X..)*
+//     F = Optional(X.. F)              F = X*
+//     F = OptionList(X.. F, X..)       F = X+
+// The lists of elements are copied, since creating the loop moves the scheme's lists.
+static bool findTailLoop(ParseScheme* scheme, uint32_t forwardIndex, TailLoop* loop_ret) {
+	ParseRule* rule = scheme->rules + forwardIndex;
+	ParseRule* list = NULL;
+	ParseRule* sepList = NULL;
+	size_t minReps = 1;
+
+	if(isPlainSequence(rule, 2)) {
+		ParseRule* last = Rule_GetListRule(rule, rule->sequenceRule.rulesLen - 1);
+		if(last->ruleType != PARSE_RULE_OPTIONAL) {
+			return false;
+		}
+
+		ParseRule* tail = Rule_GetInnerRule(last);
+		if(isForwardRule(scheme, Rule_GetIndex(tail), forwardIndex)) {
+			list = rule;
+		} else if(isPlainSequence(tail, 2) && isForwardRule(scheme, Rule_GetIndex(Rule_GetListRule(tail, tail->sequenceRule.rulesLen - 1)), forwardIndex)) {
+			list = rule;
+			sepList = tail;
+			minReps = 0;
+		} else {
+			return false;
+		}
+	} else if(rule->ruleType == PARSE_RULE_OPTIONAL) {
+		list = Rule_GetInnerRule(rule);
+		minReps = 0;
+	} else if((rule->ruleType == PARSE_RULE_OPTION_LIST) && (rule->optionListRule.rulesLen == 2)) {
+		list = Rule_GetListRule(rule, 0);
+	} else {
+		return false;
+	}
+
+	if(!isPlainSequence(list, 2) || ((list != rule) && !isForwardRule(scheme, Rule_GetIndex(Rule_GetListRule(list, list->sequenceRule.rulesLen - 1)), forwardIndex))) {
+		return false;
+	}
+
+	size_t headLen = list->sequenceRule.rulesLen - 1;
+	uint32_t* head = scheme->childIndices + list->sequenceRule.firstRule;
+
+	if((rule->ruleType == PARSE_RULE_OPTION_LIST) && !isSameSequence(scheme, Rule_GetIndex(Rule_GetListRule(rule, 1)), head, headLen)) {
+		return false;
+	}
+
+	size_t sepLen = (sepList != NULL)? sepList->sequenceRule.rulesLen - 1 : 0;
+	(*loop_ret) = (TailLoop) {
+		.head = (uint32_t*) malloc(sizeof(uint32_t) * (headLen + sepLen + headLen)),
+		.headLen = headLen,
+		.sep = NULL,
+		.sepLen = sepLen,
+		.minReps = minReps
+	};
+
+	if(loop_ret->head == NULL) {
+		return false;
+	}
+
+	// The separator is followed by another head, so they're stored as the elements of that sequence.
+	memcpy(loop_ret->head, head, sizeof(uint32_t) * headLen);
+	if(sepList != NULL) {
+		loop_ret->sep = loop_ret->head + headLen;
+		memcpy(loop_ret->sep, scheme->childIndices + sepList->sequenceRule.firstRule, sizeof(uint32_t) * sepLen);
+		memcpy(loop_ret->sep + sepLen, head, sizeof(uint32_t) * headLen);
+	}
+
+	return true;
+}
+
+// Like SequenceRule_Create, but from rule indices. A single element is returned as it is.
+static uint32_t createSequence(ParseScheme* scheme, uint32_t* elements, size_t len) {
+	if(len == 1) {
+		return elements[0];
+	}
+
+	ParseRule** rules = (ParseRule**) malloc(sizeof(ParseRule*) * len);
+	ParseRule* ret = (rules != NULL)? getSchemeSpaceForNewRule(scheme) : NULL;
+
+	if(ret == NULL) {
+		free(rules);
+		return UINT32_MAX;
+	}
+
+	for(size_t i = 0; i < len; i++) {
+		rules[i] = scheme->rules + elements[i];
+	}
+
+	uint32_t firstRule = ParseScheme_AddRulesList(scheme, rules, len);
+	free(rules);
+
+	if(firstRule == UINT32_MAX) {
+		return UINT32_MAX;
+	}
+
+	ret->sequenceRule = (RulesListRuleData) {
+		.firstRule = firstRule,
+		.rulesLen = (uint32_t) len,
+		.skip = false
+	};
+	ret->ruleType = PARSE_RULE_SEQUENCE;
+
+	return Rule_GetIndex(ParseScheme_InternRule(scheme, ret));
+}
+
+static uint32_t createTailLoop(ParseScheme* scheme, TailLoop* loop) {
+	if(loop->sep == NULL) {
+		uint32_t body = createSequence(scheme, loop->head, loop->headLen);
+		if(body == UINT32_MAX) {
+			return UINT32_MAX;
+		}
+
+		ParseRule* repeat = RepeatRule_CreateWithBounds(scheme, loop->minReps, SIZE_MAX, scheme->rules + body);
+		return (repeat != NULL)? Rule_GetIndex(repeat) : UINT32_MAX;
+	}
+
+	uint32_t body = createSequence(scheme, loop->sep, loop->sepLen + loop->headLen);
+	ParseRule* repeat = (body != UINT32_MAX)? RepeatRule_Create(scheme, false, scheme->rules + body) : NULL;
+
+	if(repeat == NULL) {
+		return UINT32_MAX;
+	}
+
+	loop->head[loop->headLen] = Rule_GetIndex(repeat);
+	return createSequence(scheme, loop->head, loop->headLen + 1);
+}
+
+// Recursion takes a stack frame per repetition, while a repeat rule loops. The forward rule takes the loop as
+// its value instead, so that everything that refers to it uses the loop.
+static bool convertTailRecursion(ParseScheme* scheme) {
+	size_t numRules = scheme->numRules;
+
+	for(size_t i = 0; i < numRules; i++) {
+		if(!scheme->rules[i].wasForwardDeclaration) {
+			continue;
+		}
+
+		// Recursion that has already been compiled into a DFA doesn't take any stack.
+		bool hasDfa = false;
+		for(size_t j = 0; (scheme->dfas != NULL) && (j < numRules); j++) {
+			if(scheme->rules[j].hasDfa && isForwardRule(scheme, (uint32_t) j, (uint32_t) i)) {
+				hasDfa = true;
+				break;
+			}
+		}
+
+		TailLoop loop;
+		if(hasDfa || !findTailLoop(scheme, (uint32_t) i, &loop)) {
+			continue;
+		}
+
+		uint32_t value = createTailLoop(scheme, &loop);
+		free(loop.head);
+
+		if(value == UINT32_MAX) {
+			if(scheme->errorState == 0) {
+				scheme->errorState = 2;
+			}
+			return false;
+		}
+
+		scheme->rules[i] = scheme->rules[value];
+		scheme->rules[i].wasForwardDeclaration = true;
+		scheme->rules[i].hasDfa = false;
+	}
+
+	return true;
+}
+
+// =================================
+// Relayout
+// =================================
+
+static bool findCanonicalRules(Relayout* relayout) {
+	ParseScheme* scheme = relayout->scheme;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+		relayout->canonical[i] = (uint32_t) i;
+
+		if(!rule->wasForwardDeclaration) {
+			continue;
+		}
+
+		relayout->canonical[i] = UINT32_MAX;
+		for(size_t j = 0; j < scheme->numRules; j++) {
+			if(!scheme->rules[j].wasForwardDeclaration && hasSameData(rule, scheme->rules + j)) {
+				relayout->canonical[i] = (uint32_t) j;
+				break;
+			}
+		}
+
+		if(relayout->canonical[i] == UINT32_MAX) {
+			fprintf(stderr, "Error: unable to find the value of forward rule %zu while finalizing.\n", i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool pushRule(Relayout* relayout, uint32_t index) {
+	index = relayout->canonical[index];
+
+	if(relayout->newIndices[index] != UINT32_MAX) {
+		return true;
+	}
+
+	if(relayout->stackLen == relayout->maxStack) {
+		size_t newLength = relayout->maxStack * 2 + 16;
+		uint32_t* newStack = (uint32_t*) realloc(relayout->stack, sizeof(uint32_t) * newLength);
+
+		if(newStack == NULL) {
+			return false;
+		}
+
+		relayout->stack = newStack;
+		relayout->maxStack = newLength;
+	}
+
+	relayout->stack[relayout->stackLen++] = index;
+	return true;
+}
+
+static ParseRule* pushCustomChild(ParseRule* child, void* mapData) {
+	Relayout* relayout = (Relayout*) mapData;
+
+	if(!pushRule(relayout, Rule_GetIndex(child))) {
+		relayout->scheme->errorState = 2;
+	}
+
+	return child;
+}
+
+// Pushes the rule's children so that the first one is popped first.
+static bool pushChildren(Relayout* relayout, ParseRule* rule) {
+	ParseScheme* scheme = relayout->scheme;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_SEQUENCE:
+		case PARSE_RULE_OPTION_LIST:
+			for(size_t i = rule->sequenceRule.rulesLen; i > 0; i--) {
+				if(!pushRule(relayout, scheme->childIndices[rule->sequenceRule.firstRule + i - 1])) {
+					return false;
+				}
+			}
+			return true;
+		case PARSE_RULE_OPTIONAL:
+			return pushRule(relayout, rule->optionalRule.rule);
+		case PARSE_RULE_REPEAT:
+			return pushRule(relayout, rule->repeatRule.rule);
+		case PARSE_RULE_LAZY:
+			// The skip rule is parsed first.
+			return pushRule(relayout, rule->lazyRule.rule)
+				&& ((rule->lazyRule.skipRule == UINT32_MAX) || pushRule(relayout, rule->lazyRule.skipRule));
+		case PARSE_RULE_OPERATOR_PRECEDENCE:
+			for(size_t i = rule->operatorRule.numOperators; i > 0; i--) {
+				if(!pushRule(relayout, scheme->childIndices[rule->operatorRule.firstOperator + i - 1])) {
+					return false;
+				}
+			}
+			return pushRule(relayout, rule->operatorRule.operand);
+		case PARSE_RULE_SEPARATED_LIST:
+			return pushRule(relayout, rule->separatedListRule.separator)
+				&& pushRule(relayout, rule->separatedListRule.item);
+		default: {
+			const ParseRuleVTable* vtable = ParseRuleType_GetVTable(rule->ruleType);
+			if((vtable == NULL) || (vtable->mapRules == NULL)) {
+				return true;
+			}
+
+			// Custom rules can only be walked forwards, so their children are reversed on the stack afterwards.
+			size_t firstPushed = relayout->stackLen;
+			vtable->mapRules(rule, pushCustomChild, relayout);
+			for(size_t i = firstPushed, j = relayout->stackLen; i + 1 < j; i++, j--) {
+				uint32_t swap = relayout->stack[i];
+				relayout->stack[i] = relayout->stack[j - 1];
+				relayout->stack[j - 1] = swap;
+			}
+			return scheme->errorState == 0;
+		}
+	}
+}
+
+// Numbers the rules in depth-first preorder from the roots.
+static bool numberRules(Relayout* relayout, ParseRule** roots, size_t numRoots) {
+	ParseScheme* scheme = relayout->scheme;
+
+	for(size_t i = numRoots; i > 0; i--) {
+		if(!pushRule(relayout, Rule_GetIndex(roots[i - 1]))) {
+			return false;
+		}
+	}
+
+	while(relayout->stackLen > 0) {
+		uint32_t index = relayout->stack[--relayout->stackLen];
+
+		if(relayout->newIndices[index] != UINT32_MAX) {
+			continue;
+		}
+
+		relayout->newIndices[index] = (uint32_t) relayout->numLive++;
+
+		if(!pushChildren(relayout, scheme->rules + index)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static uint32_t mapIndex(Relayout* relayout, uint32_t index) {
+	return relayout->newIndices[relayout->canonical[index]];
+}
+
+static ParseRule* mapCustomChild(ParseRule* child, void* mapData) {
+	Relayout* relayout = (Relayout*) mapData;
+	return relayout->newRules + mapIndex(relayout, (uint32_t) (child - relayout->scheme->rules));
+}
+
+// Lints the rules that the roots use, so that leftover rules don't get in the way. A forward rule is checked if
+// its value is.
+static bool lintKeptRules(ParseScheme* scheme, ParseRule** roots, size_t numRoots) {
+	Relayout relayout = {
+		.scheme = scheme,
+		.canonical = (uint32_t*) malloc(sizeof(uint32_t) * (scheme->numRules + 1)),
+		.newIndices = (uint32_t*) malloc(sizeof(uint32_t) * (scheme->numRules + 1)),
+		.numLive = 0,
+		.stack = NULL,
+		.stackLen = 0,
+		.maxStack = 0,
+		.newRules = NULL
+	};
+	bool* checked = (bool*) malloc(sizeof(bool) * (scheme->numRules + 1));
+
+	bool ok = (relayout.canonical != NULL) && (relayout.newIndices != NULL) && (checked != NULL);
+	if(ok) {
+		memset(relayout.newIndices, 0xFF, sizeof(uint32_t) * (scheme->numRules + 1));
+	}
+
+	ok = ok && findCanonicalRules(&relayout) && numberRules(&relayout, roots, numRoots);
+
+	ParseLintReport* report = NULL;
+	if(ok) {
+		for(size_t i = 0; i < scheme->numRules; i++) {
+			checked[i] = (relayout.newIndices[relayout.canonical[i]] != UINT32_MAX);
+		}
+		report = ParseScheme_LintRules(scheme, checked);
+	}
+
+	free(relayout.canonical);
+	free(relayout.newIndices);
+	free(relayout.stack);
+	free(checked);
+
+	if(report == NULL) {
+		if(scheme->errorState == 0) {
+			fprintf(stderr, "Error: unable to allocate space to lint the scheme!\n");
+			scheme->errorState = 2;
+		}
+		return false;
+	}
+
+	if(report->numIssues > 0) {
+		ParseLintReport_Print(report, stderr);
+	}
+
+	bool accepted = (report->numErrors == 0);
+	ParseLintReport_Free(report);
+
+	if(!accepted) {
+		fprintf(stderr, "Error: the scheme can't be finalized until the errors found by lint are fixed.\n");
+	}
+
+	return accepted;
+}
+
+bool ParseScheme_Finalize(ParseScheme* scheme, ParseRule** roots, size_t numRoots) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return false;
+	}
+
+	if((roots == NULL) && (numRoots > 0)) {
+		fprintf(stderr, "Error: attempting to finalize a scheme with null roots.\n");
+		scheme->errorState = 3;
+		return false;
+	}
+
+	for(size_t i = 0; i < numRoots; i++) {
+		if((roots[i] == NULL) || (roots[i]->scheme != scheme)) {
+			fprintf(stderr, "Error: attempting to finalize a scheme with a root that is null or from another scheme.\n");
+			scheme->errorState = 3;
+			return false;
+		}
+	}
+
+	if(scheme->finalized) {
+		fprintf(stderr, "Error: attempting to finalize a scheme twice.\n");
+		scheme->errorState = 4;
+		return false;
+	}
+
+	if(scheme->numUnresolvedForwardRules != 0) {
+		fprintf(stderr, "Error: attempting to finalize a scheme with %zu forward rules that weren't given a value.\n",
+			scheme->numUnresolvedForwardRules);
+		scheme->errorState = 4;
+		return false;
+	}
+
+	// The rules are checked before anything is changed, so that a scheme with errors can still be fixed.
+	if(!lintKeptRules(scheme, roots, numRoots)) {
+		return false;
+	}
+
+	if(!convertTailRecursion(scheme)) {
+		fprintf(stderr, "Error: unable to allocate space to turn tail recursion into loops!\n");
+		return false;
+	}
+
+	Relayout relayout = {
+		.scheme = scheme,
+		.canonical = (uint32_t*) malloc(sizeof(uint32_t) * (scheme->numRules + 1)),
+		.newIndices = (uint32_t*) malloc(sizeof(uint32_t) * (scheme->numRules + 1)),
+		.numLive = 0,
+		.stack = NULL,
+		.stackLen = 0,
+		.maxStack = 0,
+		.newRules = NULL
+	};
+
+	bool ok = (relayout.canonical != NULL) && (relayout.newIndices != NULL);
+	if(ok) {
+		memset(relayout.newIndices, 0xFF, sizeof(uint32_t) * (scheme->numRules + 1));
+	}
+
+	ok = ok && findCanonicalRules(&relayout) && numberRules(&relayout, roots, numRoots);
+
+	// Only the list contents and text of the rules that are kept are copied, in the rules' new order.
+	size_t numChildIndices = 0;
+	size_t stringPoolLen = 0;
+	for(size_t i = 0; ok && (i < scheme->numRules); i++) {
+		ParseRule* rule = scheme->rules + i;
+		if(relayout.newIndices[i] == UINT32_MAX) {
+			continue;
+		}
+		if((rule->ruleType == PARSE_RULE_SEQUENCE) || (rule->ruleType == PARSE_RULE_OPTION_LIST)) {
+			numChildIndices += rule->sequenceRule.rulesLen;
+		} else if(rule->ruleType == PARSE_RULE_ALPHABET) {
+			stringPoolLen += rule->alphabetRule.alphabetLen + 1;
+		} else if(rule->ruleType == PARSE_RULE_STRING) {
+			stringPoolLen += rule->stringRule.stringLen + 1;
+		} else if(rule->ruleType == PARSE_RULE_OPERATOR_PRECEDENCE) {
+			numChildIndices += rule->operatorRule.numOperators;
+			stringPoolLen += 2 * rule->operatorRule.numOperators + 1;
+		} else if(rule->ruleType == PARSE_RULE_SCAN_UNTIL) {
+			stringPoolLen += rule->scanUntilRule.numStops + ((rule->scanUntilRule.escape != 0)? 1 : 0) + 1;
+		}
+	}
+	uint32_t skipperText[3] = { scheme->skipLineComment, scheme->skipBlockCommentStart, scheme->skipBlockCommentEnd };
+	for(size_t i = 0; i < 3; i++) {
+		if(skipperText[i] != UINT32_MAX) {
+			stringPoolLen += strlen(scheme->stringPool + skipperText[i]) + 1;
+		}
+	}
+
+	size_t maxRules = (relayout.numLive > 0)? relayout.numLive : 1;
+	ParseRule* newRules = ok? (ParseRule*) malloc(sizeof(ParseRule) * maxRules) : NULL;
+	uint32_t* newChildIndices = ok? (uint32_t*) malloc(sizeof(uint32_t) * (numChildIndices + 1)) : NULL;
+	char* newStringPool = ok? (char*) malloc(stringPoolLen + 1) : NULL;
+	ParseDfa** newDfas = (ok && (scheme->dfas != NULL))? (ParseDfa**) calloc(maxRules, sizeof(ParseDfa*)) : NULL;
+
+	if(!ok || (newRules == NULL) || (newChildIndices == NULL) || (newStringPool == NULL) || ((scheme->dfas != NULL) && (newDfas == NULL))) {
+		if(scheme->errorState == 0) {
+			fprintf(stderr, "Error: unable to allocate space to finalize the scheme!\n");
+			scheme->errorState = 2;
+		}
+		free(relayout.canonical);
+		free(relayout.newIndices);
+		free(relayout.stack);
+		free(newRules);
+		free(newChildIndices);
+		free(newStringPool);
+		free(newDfas);
+		return false;
+	}
+
+	relayout.newRules = newRules;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		if(relayout.newIndices[i] != UINT32_MAX) {
+			newRules[relayout.newIndices[i]] = scheme->rules[i];
+			if(scheme->rules[i].hasDfa) {
+				newDfas[relayout.newIndices[i]] = scheme->dfas[i];
+			}
+		}
+	}
+
+	// Copy the data in the new order, so that it is laid out the same way as the rules.
+	numChildIndices = 0;
+	stringPoolLen = 0;
+	for(size_t n = 0; n < relayout.numLive; n++) {
+		ParseRule* rule = newRules + n;
+
+		switch(rule->ruleType) {
+			case PARSE_RULE_SEQUENCE:
+			case PARSE_RULE_OPTION_LIST:
+				for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+					newChildIndices[numChildIndices + i] = mapIndex(&relayout, scheme->childIndices[rule->sequenceRule.firstRule + i]);
+				}
+				rule->sequenceRule.firstRule = (uint32_t) numChildIndices;
+				numChildIndices += rule->sequenceRule.rulesLen;
+				break;
+			case PARSE_RULE_ALPHABET:
+				memcpy(newStringPool + stringPoolLen, scheme->stringPool + rule->alphabetRule.alphabet, rule->alphabetRule.alphabetLen + 1);
+				rule->alphabetRule.alphabet = (uint32_t) stringPoolLen;
+				stringPoolLen += rule->alphabetRule.alphabetLen + 1;
+				break;
+			case PARSE_RULE_STRING:
+				memcpy(newStringPool + stringPoolLen, scheme->stringPool + rule->stringRule.string, rule->stringRule.stringLen + 1);
+				rule->stringRule.string = (uint32_t) stringPoolLen;
+				stringPoolLen += rule->stringRule.stringLen + 1;
+				break;
+			case PARSE_RULE_OPTIONAL:
+				rule->optionalRule.rule = mapIndex(&relayout, rule->optionalRule.rule);
+				break;
+			case PARSE_RULE_REPEAT:
+				rule->repeatRule.rule = mapIndex(&relayout, rule->repeatRule.rule);
+				break;
+			case PARSE_RULE_LAZY:
+				rule->lazyRule.rule = mapIndex(&relayout, rule->lazyRule.rule);
+				if(rule->lazyRule.skipRule != UINT32_MAX) {
+					rule->lazyRule.skipRule = mapIndex(&relayout, rule->lazyRule.skipRule);
+				}
+				break;
+			case PARSE_RULE_OPERATOR_PRECEDENCE: {
+				size_t numOperators = rule->operatorRule.numOperators;
+				for(size_t i = 0; i < numOperators; i++) {
+					newChildIndices[numChildIndices + i] = mapIndex(&relayout, scheme->childIndices[rule->operatorRule.firstOperator + i]);
+				}
+				memcpy(newStringPool + stringPoolLen, scheme->stringPool + rule->operatorRule.operatorInfo, 2 * numOperators + 1);
+				rule->operatorRule.operand = mapIndex(&relayout, rule->operatorRule.operand);
+				rule->operatorRule.firstOperator = (uint32_t) numChildIndices;
+				rule->operatorRule.operatorInfo = (uint32_t) stringPoolLen;
+				numChildIndices += numOperators;
+				stringPoolLen += 2 * numOperators + 1;
+				break;
+			}
+			case PARSE_RULE_SEPARATED_LIST:
+				rule->separatedListRule.item = mapIndex(&relayout, rule->separatedListRule.item);
+				rule->separatedListRule.separator = mapIndex(&relayout, rule->separatedListRule.separator);
+				break;
+			case PARSE_RULE_SCAN_UNTIL: {
+				size_t len = rule->scanUntilRule.numStops + ((rule->scanUntilRule.escape != 0)? 1 : 0) + 1;
+				memcpy(newStringPool + stringPoolLen, scheme->stringPool + rule->scanUntilRule.stops, len);
+				rule->scanUntilRule.stops = (uint32_t) stringPoolLen;
+				stringPoolLen += len;
+				break;
+			}
+			default: {
+				const ParseRuleVTable* vtable = ParseRuleType_GetVTable(rule->ruleType);
+				if((vtable != NULL) && (vtable->mapRules != NULL)) {
+					vtable->mapRules(rule, mapCustomChild, &relayout);
+				}
+				break;
+			}
+		}
+	}
+
+	for(size_t i = 0; i < 3; i++) {
+		if(skipperText[i] != UINT32_MAX) {
+			size_t len = strlen(scheme->stringPool + skipperText[i]) + 1;
+			memcpy(newStringPool + stringPoolLen, scheme->stringPool + skipperText[i], len);
+			skipperText[i] = (uint32_t) stringPoolLen;
+			stringPoolLen += len;
+		}
+	}
+
+	// Dropped rules are freed, except for forward rules, which share their data with their value.
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+		if((relayout.newIndices[i] == UINT32_MAX) && !rule->wasForwardDeclaration) {
+			if(rule->hasDfa) {
+				ParseDfa_Free(scheme->dfas[i]);
+			}
+			Rule_Free(rule);
+		}
+	}
+
+	for(size_t i = 0; i < numRoots; i++) {
+		roots[i] = newRules + mapIndex(&relayout, Rule_GetIndex(roots[i]));
+	}
+
+	free(scheme->rules);
+	free(scheme->childIndices);
+	free(scheme->stringPool);
+	free(scheme->dfas);
+	free(scheme->ruleLengths);
+
+	scheme->rules = newRules;
+	scheme->numRules = relayout.numLive;
+	scheme->maxRules = maxRules;
+	scheme->childIndices = newChildIndices;
+	scheme->numChildIndices = numChildIndices;
+	scheme->maxChildIndices = numChildIndices + 1;
+	scheme->stringPool = newStringPool;
+	scheme->stringPoolLen = stringPoolLen;
+	scheme->maxStringPoolLen = stringPoolLen + 1;
+	scheme->dfas = newDfas;
+	scheme->maxDfas = (newDfas != NULL)? maxRules : 0;
+	scheme->ruleLengths = NULL;
+	scheme->numRuleLengths = 0;
+	scheme->skipLineComment = skipperText[0];
+	scheme->skipBlockCommentStart = skipperText[1];
+	scheme->skipBlockCommentEnd = skipperText[2];
+	scheme->finalized = true;
+
+	ParseScheme_RebuildInternTable(scheme);
+
+	free(relayout.canonical);
+	free(relayout.newIndices);
+	free(relayout.stack);
+
+	return ParseScheme_ComputeRuleLengths(scheme);
+}
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stddef.h>
 #include <math.h>
+#include <time.h>
 #include "ParseFramework.h"
 #include "AlphabetParseRule.h"
 #include "OptionListParseRule.h"
@@ -11,9 +12,131 @@
 #include "ForwardParseRule.h"
 #include "OptionalParseRule.h"
 #include "RepeatParseRule.h"
+#include "CutParseRule.h"
+#include "TokenParseRule.h"
+#include "LazyParseRule.h"
+#include "SkipParseRule.h"
+#include "OperatorPrecedenceParseRule.h"
+#include "SeparatedListParseRule.h"
+#include "ScanUntilParseRule.h"
+#include "ParseDfa.h"
+#include "ParseMemo.h"
+#include "ParseTrace.h"
+#include "ParseHeatmap.h"
+#include "ParseEvents.h"
 
 const size_t PARSE_SCHEME_BUFFER_LENGTH = 100;
 
+// How many steps a parse takes between checking its cancel flag and deadline.
+const size_t PARSE_LIMIT_CHECK_INTERVAL = 1024;
+
+// Room for the built-in rule types plus the ones registered with ParseRuleType_Register.
+#define PARSE_RULE_MAX_TYPES 64
+
+static ParseResult parseUntypedRule(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	fprintf(stderr, "Error: I don't know how to parse using that rule.\n");
+	return setParseResult(result_ret, false, NULL, 0);
+}
+
+static void printUntypedRule(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "Unknown Rule Type\n");
+}
+
+static ParseResult parseUnresolvedForwardRule(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	fprintf(stderr,
+		"Error: attempting to parse using a forward declared rule that hasn't been given a value! "
+		"Make sure to eventually call Rule_SetForwardRuleValue for every forward rule that you declare.\n"
+	);
+	return setParseResult(result_ret, false, NULL, 0);
+}
+
+// Indexed by ruleType. Rule types that aren't used are dispatched to the untyped functions.
+static ParseRuleVTable ruleVTables[PARSE_RULE_MAX_TYPES] = {
+	[PARSE_RULE_NO_TYPE] = {
+		.name = "None",
+		.parse = parseUntypedRule,
+		.print = printUntypedRule
+	},
+	[PARSE_RULE_ALPHABET] = {
+		.name = "Alphabet",
+		.parse = AlphabetRule_Parse,
+		.print = AlphabetRule_Print
+	},
+	[PARSE_RULE_OPTION_LIST] = {
+		.name = "OptionList",
+		.parse = OptionListRule_Parse,
+		.print = OptionListRule_Print,
+		.printDeep = OptionListRule_PrintDeep
+	},
+	[PARSE_RULE_SEQUENCE] = {
+		.name = "Sequence",
+		.parse = SequenceRule_Parse,
+		.print = SequenceRule_Print,
+		.printDeep = SequenceRule_PrintDeep
+	},
+	[PARSE_RULE_FORWARD_DECLARED] = {
+		.name = "Forward",
+		.parse = parseUnresolvedForwardRule,
+		.print = ForwardRule_Print
+	},
+	[PARSE_RULE_STRING] = {
+		.name = "String",
+		.parse = StringRule_Parse,
+		.print = StringRule_Print
+	},
+	[PARSE_RULE_OPTIONAL] = {
+		.name = "Optional",
+		.parse = OptionalRule_Parse,
+		.print = OptionalRule_Print,
+		.printDeep = OptionalRule_PrintDeep
+	},
+	[PARSE_RULE_REPEAT] = {
+		.name = "Repeat",
+		.parse = RepeatRule_Parse,
+		.print = RepeatRule_Print,
+		.printDeep = RepeatRule_PrintDeep
+	},
+	[PARSE_RULE_CUT] = {
+		.name = "Cut",
+		.parse = CutRule_Parse,
+		.print = CutRule_Print
+	},
+	[PARSE_RULE_TOKEN] = {
+		.name = "Token",
+		.parse = TokenRule_Parse,
+		.print = TokenRule_Print
+	},
+	[PARSE_RULE_LAZY] = {
+		.name = "Lazy",
+		.parse = LazyRule_Parse,
+		.print = LazyRule_Print,
+		.printDeep = LazyRule_PrintDeep
+	},
+	[PARSE_RULE_SKIP] = {
+		.name = "Skip",
+		.parse = SkipRule_Parse,
+		.print = SkipRule_Print
+	},
+	[PARSE_RULE_OPERATOR_PRECEDENCE] = {
+		.name = "OperatorPrecedence",
+		.parse = OperatorPrecedenceRule_Parse,
+		.print = OperatorPrecedenceRule_Print,
+		.printDeep = OperatorPrecedenceRule_PrintDeep
+	},
+	[PARSE_RULE_SEPARATED_LIST] = {
+		.name = "SeparatedList",
+		.parse = SeparatedListRule_Parse,
+		.print = SeparatedListRule_Print,
+		.printDeep = SeparatedListRule_PrintDeep
+	},
+	[PARSE_RULE_SCAN_UNTIL] = {
+		.name = "ScanUntil",
+		.parse = ScanUntilRule_Parse,
+		.print = ScanUntilRule_Print
+	}
+};
+static size_t numRuleTypes = PARSE_RULE_NUM_BUILTIN_TYPES;
+
 ParseScheme* ParseScheme_Create() {
 	ParseScheme* ret = (ParseScheme*) malloc(sizeof(ParseScheme));
 
@@ -32,13 +155,39 @@ ParseScheme* ParseScheme_Create() {
 
 	ret->numRules = 0;
 	ret->maxRules = PARSE_SCHEME_BUFFER_LENGTH;
+	ret->childIndices = NULL;
+	ret->numChildIndices = 0;
+	ret->maxChildIndices = 0;
+	ret->stringPool = NULL;
+	ret->stringPoolLen = 0;
+	ret->maxStringPoolLen = 0;
+	ret->dfas = NULL;
+	ret->maxDfas = 0;
+	ret->ruleLengths = NULL;
+	ret->numRuleLengths = 0;
+	ret->hashConsing = true;
+	ret->internTable = NULL;
+	ret->internTableSize = 0;
+	ret->numInterned = 0;
+	ret->skipping = false;
+	ret->numSkipBytes = 0;
+	ret->skipLineComment = UINT32_MAX;
+	ret->skipBlockCommentStart = UINT32_MAX;
+	ret->skipBlockCommentEnd = UINT32_MAX;
 	ret->errorState = 0;
 	ret->numUnresolvedForwardRules = 0;
+	ret->finalized = false;
 
 	return ret;
 }
 
 void ParseScheme_Free(ParseScheme* scheme) {
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		if(scheme->rules[i].hasDfa) {
+			ParseDfa_Free(scheme->dfas[i]);
+		}
+	}
+
 	// Free individual rules.
 	for(size_t i = 0; i < scheme->numRules; i++) {
 		Rule_Free(&(scheme->rules[i]));
@@ -47,6 +196,18 @@ void ParseScheme_Free(ParseScheme* scheme) {
 
 	free(scheme->rules);
 	scheme->rules = NULL;
+	free(scheme->childIndices);
+	scheme->childIndices = NULL;
+	free(scheme->stringPool);
+	scheme->stringPool = NULL;
+	free(scheme->dfas);
+	scheme->dfas = NULL;
+	free(scheme->ruleLengths);
+	scheme->ruleLengths = NULL;
+	scheme->numRuleLengths = 0;
+	free(scheme->internTable);
+	scheme->internTable = NULL;
+	scheme->internTableSize = 0;
 	scheme->errorState = -1;
 }
 
@@ -55,6 +216,12 @@ ParseRule* getSchemeSpaceForNewRule(ParseScheme* scheme) {
 		return NULL;
 	}
 
+	if(scheme->finalized) {
+		fprintf(stderr, "Error: attempting to add a rule to a finalized scheme.\n");
+		scheme->errorState = 4;
+		return NULL;
+	}
+
 
 	if(scheme->numRules == scheme->maxRules) {
 		size_t newLength = scheme->maxRules + PARSE_SCHEME_BUFFER_LENGTH;
@@ -90,6 +257,7 @@ ParseRule* getSchemeSpaceForNewRule(ParseScheme* scheme) {
 	scheme->rules[scheme->numRules - 1] = (ParseRule) {
 		.ruleType = PARSE_RULE_NO_TYPE,
 		.wasForwardDeclaration = false,
+		.hasDfa = false,
 		.scheme = scheme
 	};
 
@@ -123,78 +291,728 @@ void ParseScheme_Print(ParseScheme* scheme, FILE* fout) {
 }
 
 
+uint32_t ParseScheme_AddString(ParseScheme* scheme, const char* str, size_t len) {
+	if(scheme->stringPoolLen + len + 1 > scheme->maxStringPoolLen) {
+		size_t newLength = scheme->maxStringPoolLen * 2 + len + 1;
+		char* newPool = (newLength <= UINT32_MAX)? (char*) realloc(scheme->stringPool, newLength) : NULL;
 
-void Rule_Free(ParseRule* rule) {
-	if(rule == NULL) {
-		return;
+		if(newPool == NULL) {
+			fprintf(stderr, "Error: cannot allocate space for a rule's text in the parse scheme.\n");
+			ParseScheme_Free(scheme);
+			scheme->errorState = 2;
+			return UINT32_MAX;
+		}
+
+		scheme->stringPool = newPool;
+		scheme->maxStringPoolLen = newLength;
 	}
 
+	uint32_t offset = (uint32_t) scheme->stringPoolLen;
+
+	memcpy(scheme->stringPool + offset, str, len);
+	scheme->stringPool[offset + len] = '\0';
+	scheme->stringPoolLen += len + 1;
+
+	return offset;
+}
+
+uint32_t ParseScheme_AddRulesList(ParseScheme* scheme, ParseRule** rules, size_t numRules) {
+	if(scheme->numChildIndices + numRules > scheme->maxChildIndices) {
+		size_t newLength = scheme->maxChildIndices * 2 + numRules;
+		uint32_t* newIndices = (newLength <= UINT32_MAX)?
+			(uint32_t*) realloc(scheme->childIndices, sizeof(uint32_t) * newLength) : NULL;
+
+		if(newIndices == NULL) {
+			fprintf(stderr, "Error: cannot allocate space for a rule's list of rules in the parse scheme.\n");
+			ParseScheme_Free(scheme);
+			scheme->errorState = 2;
+			return UINT32_MAX;
+		}
+
+		scheme->childIndices = newIndices;
+		scheme->maxChildIndices = newLength;
+	}
+
+	uint32_t first = (uint32_t) scheme->numChildIndices;
+
+	for(size_t i = 0; i < numRules; i++) {
+		scheme->childIndices[first + i] = Rule_GetIndex(rules[i]);
+	}
+	scheme->numChildIndices += numRules;
+
+	return first;
+}
+
+static bool canInternRule(ParseRule* rule) {
 	if(rule->wasForwardDeclaration) {
-		return;
+		return false;
 	}
 
 	switch(rule->ruleType) {
 		case PARSE_RULE_ALPHABET:
-			AlphabetRule_Free(rule->alphabetRule);
-			rule->alphabetRule = NULL;
-			break;
+		case PARSE_RULE_STRING:
+		case PARSE_RULE_SEQUENCE:
 		case PARSE_RULE_OPTION_LIST:
-			OptionListRule_Free(rule->optionListRule);
-			rule->optionListRule = NULL;
-			break;
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// FNV-1a
+static uint64_t hashBytes(uint64_t hash, const void* bytes, size_t len) {
+	for(size_t i = 0; i < len; i++) {
+		hash ^= ((const unsigned char*) bytes)[i];
+		hash *= 0x100000001B3;
+	}
+	return hash;
+}
+
+static uint64_t hashRule(ParseRule* rule) {
+	ParseScheme* scheme = rule->scheme;
+	uint64_t hash = hashBytes(0xCBF29CE484222325, &rule->ruleType, sizeof(rule->ruleType));
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			hash = hashBytes(hash, &rule->alphabetRule.caseInsensitive, sizeof(bool));
+			return hashBytes(hash, Rule_GetText(rule), rule->alphabetRule.alphabetLen);
+		case PARSE_RULE_STRING:
+			hash = hashBytes(hash, &rule->stringRule.caseInsensitive, sizeof(bool));
+			return hashBytes(hash, Rule_GetText(rule), rule->stringRule.stringLen);
 		case PARSE_RULE_SEQUENCE:
-			SequenceRule_Free(rule->sequenceRule);
-			rule->sequenceRule = NULL;
-			break;
+		case PARSE_RULE_OPTION_LIST:
+			hash = hashBytes(hash, &rule->sequenceRule.skip, sizeof(bool));
+			return hashBytes(hash, scheme->childIndices + rule->sequenceRule.firstRule,
+				sizeof(uint32_t) * rule->sequenceRule.rulesLen);
+		case PARSE_RULE_OPTIONAL:
+			return hashBytes(hash, &rule->optionalRule.rule, sizeof(uint32_t));
+		case PARSE_RULE_REPEAT:
+			hash = hashBytes(hash, &rule->repeatRule.rule, sizeof(uint32_t));
+			hash = hashBytes(hash, &rule->repeatRule.minReps, sizeof(size_t));
+			return hashBytes(hash, &rule->repeatRule.maxReps, sizeof(size_t));
+		default:
+			return hash;
+	}
+}
+
+static bool rulesAreIdentical(ParseRule* a, ParseRule* b) {
+	if((a->ruleType != b->ruleType) || !canInternRule(a) || !canInternRule(b)) {
+		return false;
+	}
+
+	ParseScheme* scheme = a->scheme;
+
+	switch(a->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			return (a->alphabetRule.caseInsensitive == b->alphabetRule.caseInsensitive)
+				&& (a->alphabetRule.alphabetLen == b->alphabetRule.alphabetLen)
+				&& (memcmp(Rule_GetText(a), Rule_GetText(b), a->alphabetRule.alphabetLen) == 0);
 		case PARSE_RULE_STRING:
-			StringRule_Free(rule->stringRule);
-			rule->stringRule = NULL;
-			break;
+			return (a->stringRule.caseInsensitive == b->stringRule.caseInsensitive)
+				&& (a->stringRule.stringLen == b->stringRule.stringLen)
+				&& (memcmp(Rule_GetText(a), Rule_GetText(b), a->stringRule.stringLen) == 0);
+		case PARSE_RULE_SEQUENCE:
+		case PARSE_RULE_OPTION_LIST:
+			return (a->sequenceRule.rulesLen == b->sequenceRule.rulesLen)
+				&& (a->sequenceRule.skip == b->sequenceRule.skip)
+				&& (memcmp(scheme->childIndices + a->sequenceRule.firstRule, scheme->childIndices + b->sequenceRule.firstRule,
+					sizeof(uint32_t) * a->sequenceRule.rulesLen) == 0);
 		case PARSE_RULE_OPTIONAL:
-			OptionalRule_Free(rule->optionalRule);
-			rule->optionalRule = NULL;
-			break;
+			return a->optionalRule.rule == b->optionalRule.rule;
 		case PARSE_RULE_REPEAT:
-			RepeatRule_Free(rule->repeatRule);
-			rule->repeatRule = NULL;
+			return (a->repeatRule.rule == b->repeatRule.rule)
+				&& (a->repeatRule.minReps == b->repeatRule.minReps)
+				&& (a->repeatRule.maxReps == b->repeatRule.maxReps);
+		default:
+			return false;
+	}
+}
+
+// Returns the slot that holds a rule identical to the given one, or the empty slot where it would go.
+static uint32_t* findInternSlot(ParseScheme* scheme, ParseRule* rule) {
+	size_t mask = scheme->internTableSize - 1;
+
+	for(size_t i = hashRule(rule) & mask; ; i = (i + 1) & mask) {
+		uint32_t* slot = scheme->internTable + i;
+		if((*slot == UINT32_MAX) || rulesAreIdentical(scheme->rules + *slot, rule)) {
+			return slot;
+		}
+	}
+}
+
+static bool growInternTable(ParseScheme* scheme) {
+	size_t newSize = (scheme->internTableSize == 0)? 64 : scheme->internTableSize * 2;
+	uint32_t* newTable = (uint32_t*) malloc(sizeof(uint32_t) * newSize);
+
+	if(newTable == NULL) {
+		return false;
+	}
+
+	memset(newTable, 0xFF, sizeof(uint32_t) * newSize);
+
+	uint32_t* oldTable = scheme->internTable;
+	size_t oldSize = scheme->internTableSize;
+
+	scheme->internTable = newTable;
+	scheme->internTableSize = newSize;
+
+	for(size_t i = 0; i < oldSize; i++) {
+		if(oldTable[i] != UINT32_MAX) {
+			(*findInternSlot(scheme, scheme->rules + oldTable[i])) = oldTable[i];
+		}
+	}
+
+	free(oldTable);
+	return true;
+}
+
+// Gives the space of the last rule, and its data at the end of the pools, back to the scheme.
+static void removeLastRule(ParseScheme* scheme, ParseRule* rule) {
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+		case PARSE_RULE_STRING: {
+			uint32_t offset = (rule->ruleType == PARSE_RULE_ALPHABET)? rule->alphabetRule.alphabet : rule->stringRule.string;
+			uint32_t len = (rule->ruleType == PARSE_RULE_ALPHABET)? rule->alphabetRule.alphabetLen : rule->stringRule.stringLen;
+			if(offset + len + 1 == scheme->stringPoolLen) {
+				scheme->stringPoolLen = offset;
+			}
+			break;
+		}
+		case PARSE_RULE_SEQUENCE:
+		case PARSE_RULE_OPTION_LIST:
+			if(rule->sequenceRule.firstRule + rule->sequenceRule.rulesLen == scheme->numChildIndices) {
+				scheme->numChildIndices = rule->sequenceRule.firstRule;
+			}
 			break;
 		default:
-			fprintf(stderr, "Error: I don't know how to free that type of parse rule.\n");
 			break;
 	}
+
+	Rule_Free(rule);
+	scheme->numRules--;
 }
 
-ParseResult Rule_Parse(ParseRule* rule, char* str, ParseResult* result_ret) {
+ParseRule* ParseScheme_InternRule(ParseScheme* scheme, ParseRule* rule) {
+	if((rule == NULL) || !scheme->hashConsing || !canInternRule(rule)) {
+		return rule;
+	}
+
+	// Keep the table at most half full. If it can't grow, rules just stop being shared.
+	if((scheme->numInterned + 1) * 2 > scheme->internTableSize && !growInternTable(scheme)) {
+		return rule;
+	}
+
+	uint32_t* slot = findInternSlot(scheme, rule);
+
+	if(*slot != UINT32_MAX) {
+		ParseRule* existing = scheme->rules + *slot;
+		if(rule == scheme->rules + scheme->numRules - 1) {
+			removeLastRule(scheme, rule);
+		}
+		return existing;
+	}
+
+	(*slot) = Rule_GetIndex(rule);
+	scheme->numInterned++;
+
+	return rule;
+}
+
+void ParseScheme_RebuildInternTable(ParseScheme* scheme) {
+	if(scheme->internTableSize == 0) {
+		return;
+	}
+
+	memset(scheme->internTable, 0xFF, sizeof(uint32_t) * scheme->internTableSize);
+	scheme->numInterned = 0;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+		if(!canInternRule(rule) || ((scheme->numInterned + 1) * 2 > scheme->internTableSize)) {
+			continue;
+		}
+
+		uint32_t* slot = findInternSlot(scheme, rule);
+		if(*slot == UINT32_MAX) {
+			(*slot) = (uint32_t) i;
+			scheme->numInterned++;
+		}
+	}
+}
+
+void ParseScheme_SetHashConsing(ParseScheme* scheme, bool hashConsing) {
+	scheme->hashConsing = hashConsing;
+}
+
+size_t ParseScheme_CompileDfas(ParseScheme* scheme) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return 0;
+	}
+
+	// Rules created since the last call don't have a slot in the table yet.
+	ParseDfa** dfas = (ParseDfa**) realloc(scheme->dfas, sizeof(ParseDfa*) * scheme->maxRules);
+
+	if(dfas == NULL) {
+		fprintf(stderr, "Error: unable to allocate DFA table!\n");
+		return 0;
+	}
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		if(!scheme->rules[i].hasDfa) {
+			dfas[i] = NULL;
+		}
+	}
+	scheme->dfas = dfas;
+	scheme->maxDfas = scheme->maxRules;
+
+	size_t numCompiled = 0;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+
+		// A string rule is already a single comparison, so a DFA wouldn't make it any faster.
+		if(rule->hasDfa || (rule->ruleType == PARSE_RULE_STRING) || rule->wasForwardDeclaration) {
+			continue;
+		}
+
+		// If either of these fails, the rule just keeps being parsed the normal way.
+		if(ParseDfa_IsRegular(rule)) {
+			dfas[i] = ParseDfa_Compile(&rule, 1);
+		} else if(rule->ruleType == PARSE_RULE_OPTION_LIST) {
+			size_t numOptions = rule->optionListRule.rulesLen;
+			ParseRule** options = (ParseRule**) malloc(sizeof(ParseRule*) * numOptions);
+
+			if(options != NULL) {
+				for(size_t j = 0; j < numOptions; j++) {
+					options[j] = Rule_GetListRule(rule, j);
+				}
+				dfas[i] = ParseDfa_CompileOptions(options, numOptions);
+			}
+
+			free(options);
+		}
+
+		if(dfas[i] != NULL) {
+			rule->hasDfa = true;
+			numCompiled++;
+		}
+	}
+
+	return numCompiled;
+}
+
+static size_t rulePayloadBytes(ParseRule* rule) {
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			return rule->alphabetRule.alphabetLen + 1;
+		case PARSE_RULE_OPTION_LIST:
+		case PARSE_RULE_SEQUENCE:
+			return rule->sequenceRule.rulesLen * sizeof(uint32_t);
+		case PARSE_RULE_STRING:
+			return rule->stringRule.stringLen + 1;
+		case PARSE_RULE_OPERATOR_PRECEDENCE:
+			return rule->operatorRule.numOperators * (sizeof(uint32_t) + 2) + 1;
+		case PARSE_RULE_SCAN_UNTIL:
+			return rule->scanUntilRule.numStops + ((rule->scanUntilRule.escape != 0)? 1 : 0) + 1;
+		default:
+			return 0;
+	}
+}
+
+void ParseScheme_MemoryStats(ParseScheme* scheme, ParseMemoryStats* stats_ret) {
+	if(stats_ret == NULL) {
+		return;
+	}
+
+	(*stats_ret) = (ParseMemoryStats) { 0 };
+
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return;
+	}
+
+	stats_ret->ruleTableBytes = sizeof(ParseScheme) + scheme->maxRules * sizeof(ParseRule)
+		+ scheme->internTableSize * sizeof(uint32_t) + scheme->numRuleLengths * sizeof(ParseRuleLengths);
+	stats_ret->payloadBytes = scheme->maxStringPoolLen + scheme->maxChildIndices * sizeof(uint32_t);
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+
+		if(rule->wasForwardDeclaration) {
+			continue;
+		}
+
+		stats_ret->payloadUsedBytes += rulePayloadBytes(rule);
+		stats_ret->dfaBytes += ParseDfa_MemoryUsage(Rule_GetDfa(rule));
+	}
+
+	stats_ret->dfaBytes += scheme->maxDfas * sizeof(ParseDfa*);
+
+	stats_ret->currentBytes = stats_ret->ruleTableBytes + stats_ret->payloadBytes + stats_ret->dfaBytes;
+	stats_ret->peakBytes = stats_ret->currentBytes;
+}
+
+void Rule_Free(ParseRule* rule) {
 	if(rule == NULL) {
-		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return;
+	}
+
+	// Built-in rules store their data inline or in the scheme's pools, so only custom rules can own anything.
+	// A forward declared rule shares its data with its value, which is the one that frees it.
+	if((ruleVTables[rule->ruleType].free != NULL) && !rule->wasForwardDeclaration) {
+		ruleVTables[rule->ruleType].free(rule);
+	}
+
+	rule->ruleType = PARSE_RULE_NO_TYPE;
+	rule->hasDfa = false;
+}
+
+ParseRuleType ParseRuleType_Register(const ParseRuleVTable* vtable) {
+	if((vtable == NULL) || (vtable->parse == NULL) || (vtable->print == NULL)) {
+		fprintf(stderr, "Error: a rule type needs at least a parse and a print function.\n");
+		return PARSE_RULE_NO_TYPE;
+	}
+
+	if(numRuleTypes >= PARSE_RULE_MAX_TYPES) {
+		fprintf(stderr, "Error: unable to register another rule type!\n");
+		return PARSE_RULE_NO_TYPE;
+	}
+
+	ruleVTables[numRuleTypes] = (*vtable);
+
+	return (ParseRuleType) numRuleTypes++;
+}
+
+const ParseRuleVTable* ParseRuleType_GetVTable(ParseRuleType ruleType) {
+	if((size_t) ruleType >= numRuleTypes) {
+		return NULL;
+	}
+
+	return &ruleVTables[ruleType];
+}
+
+void ParseContext_Init(ParseContext* ctx, char* input, size_t inputLen) {
+	(*ctx) = (ParseContext) {
+		.input = input,
+		.inputLen = inputLen,
+		.cutOffset = 0,
+		.tokens = NULL,
+		.memo = NULL,
+		.ownsMemo = false,
+		.examinedEnd = 0,
+		.trace = NULL,
+		.heatmap = NULL,
+		.profile = NULL,
+		.events = NULL,
+		.numSteps = 0,
+		.nextLimitCheck = SIZE_MAX,
+		.maxSteps = 0,
+		.cancelFlag = NULL,
+		.deadline = 0,
+		.abortReason = PARSE_NOT_ABORTED
+	};
+}
+
+void ParseContext_InitWithTokens(ParseContext* ctx, TokenStream* tokens) {
+	ParseContext_Init(ctx, tokens->input, tokens->inputLen);
+	ctx->tokens = tokens;
+}
+
+void ParseContext_Free(ParseContext* ctx) {
+	if(ctx == NULL) {
+		return;
+	}
+
+	if(ctx->ownsMemo) {
+		ParseMemo_Free(ctx->memo);
+	}
+
+	ctx->input = NULL;
+	ctx->tokens = NULL;
+	ctx->memo = NULL;
+	ctx->ownsMemo = false;
+	ctx->trace = NULL;
+	ctx->heatmap = NULL;
+	ctx->profile = NULL;
+	ctx->events = NULL;
+}
+
+bool ParseContext_EnableMemo(ParseContext* ctx, size_t budgetBytes) {
+	if(ctx->memo == NULL) {
+		ctx->memo = ParseMemo_Create(ctx->inputLen);
+
+		if(ctx->memo == NULL) {
+			return false;
+		}
+
+		ctx->ownsMemo = true;
+	}
+
+	ParseMemo_SetBudget(ctx->memo, budgetBytes);
+
+	return true;
+}
+
+static uint64_t getMonotonicTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+// Returns false if the parse has to be aborted. Otherwise, works out when to check again.
+static bool checkParseLimits(ParseContext* ctx) {
+	if(ctx->abortReason != PARSE_NOT_ABORTED) {
+		return false;
+	}
+
+	if((ctx->maxSteps != 0) && (ctx->numSteps > ctx->maxSteps)) {
+		ctx->abortReason = PARSE_ABORTED_STEP_BUDGET;
+	} else if((ctx->cancelFlag != NULL) && atomic_load_explicit(ctx->cancelFlag, memory_order_relaxed)) {
+		ctx->abortReason = PARSE_ABORTED_CANCELLED;
+	} else if((ctx->deadline != 0) && (getMonotonicTime() >= ctx->deadline)) {
+		ctx->abortReason = PARSE_ABORTED_DEADLINE;
+	}
+
+	if(ctx->abortReason != PARSE_NOT_ABORTED) {
+		// Every rule that is still being parsed checks again on its way out.
+		ctx->nextLimitCheck = 0;
+		return false;
+	}
+
+	ctx->nextLimitCheck = SIZE_MAX;
+	if((ctx->cancelFlag != NULL) || (ctx->deadline != 0)) {
+		ctx->nextLimitCheck = ctx->numSteps + PARSE_LIMIT_CHECK_INTERVAL;
+	}
+	if((ctx->maxSteps != 0) && (ctx->maxSteps < ctx->nextLimitCheck)) {
+		ctx->nextLimitCheck = ctx->maxSteps + 1;
+	}
+
+	return true;
+}
+
+void ParseContext_SetStepBudget(ParseContext* ctx, size_t maxSteps) {
+	ctx->abortReason = PARSE_NOT_ABORTED;
+	ctx->numSteps = 0;
+	ctx->maxSteps = maxSteps;
+	checkParseLimits(ctx);
+}
+
+void ParseContext_SetCancelFlag(ParseContext* ctx, atomic_bool* cancelFlag) {
+	ctx->abortReason = PARSE_NOT_ABORTED;
+	ctx->cancelFlag = cancelFlag;
+	checkParseLimits(ctx);
+}
+
+void ParseContext_SetTimeout(ParseContext* ctx, uint64_t timeoutNanoseconds) {
+	ctx->abortReason = PARSE_NOT_ABORTED;
+	ctx->deadline = (timeoutNanoseconds == 0)? 0 : getMonotonicTime() + timeoutNanoseconds;
+	checkParseLimits(ctx);
+}
+
+void ParseContext_MarkExamined(ParseContext* ctx, char* str, size_t len) {
+	size_t end = (str - ctx->input) + len;
+
+	if(ctx->heatmap != NULL) {
+		ParseHeatmap_Record(ctx->heatmap, str - ctx->input, len);
+	}
+
+	if(end > ctx->examinedEnd) {
+		ctx->examinedEnd = end;
+	}
+}
+
+ParseResult Rule_Parse(ParseRule* rule, char* str, ParseResult* result_ret) {
+	if(str == NULL) {
+		fprintf(stderr, "Error: attempting to parse a null string.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
+	ParseContext ctx;
+	ParseContext_Init(&ctx, str, strlen(str));
+
+	ParseResult result = Rule_ParseWithContext(rule, &ctx, str, result_ret);
+
+	ParseContext_Free(&ctx);
+
+	return result;
+}
+
+static ParseResult parseRule(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule->hasDfa && ((ctx->events == NULL) || !ParseEvents_NeedsChildren(ctx->events, rule))) {
+		size_t length, examined;
+		bool matched = ParseDfa_Match(Rule_GetDfa(rule), str, (ctx->input + ctx->inputLen) - str, &length, NULL, &examined);
+		ParseContext_MarkExamined(ctx, str, examined);
+		if(matched) {
+			return setParseResult(result_ret, true, str, length);
+		}
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	return ruleVTables[rule->ruleType].parse(rule, ctx, str, result_ret);
+}
+
+static bool isLeaf(ParseRule* rule) {
 	switch(rule->ruleType) {
 		case PARSE_RULE_ALPHABET:
-			return AlphabetRule_Parse(rule->alphabetRule, str, result_ret);
+		case PARSE_RULE_STRING:
+		case PARSE_RULE_CUT:
+		case PARSE_RULE_TOKEN:
+		case PARSE_RULE_SKIP:
+		case PARSE_RULE_SCAN_UNTIL:
+			return true;
+		default:
+			return rule->hasDfa;
+	}
+}
+
+// A rule made of nothing but leaves is about as cheap to parse again as to look up, so only rules with
+// composite children are memoized.
+static bool shouldMemoize(ParseRule* rule) {
+	if(rule->hasDfa) {
+		return false;
+	}
+
+	switch(rule->ruleType) {
 		case PARSE_RULE_OPTION_LIST:
-			return OptionListRule_Parse(rule->optionListRule, str, result_ret);
 		case PARSE_RULE_SEQUENCE:
-			return SequenceRule_Parse(rule->sequenceRule, str, result_ret);
-		case PARSE_RULE_STRING:
-			return StringRule_Parse(rule->stringRule, str, result_ret);
-		case PARSE_RULE_FORWARD_DECLARED:
-			fprintf(stderr,
-				"Error: attempting to parse using a forward declared rule that hasn't been given a value! "
-				"Make sure to eventually call Rule_SetForwardRuleValue for every forward rule that you declare.\n"
-			);
-			return setParseResult(result_ret, false, NULL, 0);
-		case PARSE_RULE_OPTIONAL:
-			return OptionalRule_Parse(rule->optionalRule, str, result_ret);
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				if(!isLeaf(Rule_GetListRule(rule, i))) {
+					return true;
+				}
+			}
+			return false;
 		case PARSE_RULE_REPEAT:
-			return RepeatRule_Parse(rule->repeatRule, str, result_ret);
+			return !isLeaf(Rule_GetInnerRule(rule));
+		case PARSE_RULE_SEPARATED_LIST:
+			return !isLeaf(Rule_GetItemRule(rule)) || !isLeaf(Rule_GetSeparatorRule(rule));
 		default:
-			fprintf(stderr, "Error: I don't know how to parse using that rule.\n");
-			return setParseResult(result_ret, false, NULL, 0);
+			return false;
 	}
 }
 
+static ParseResult parseMemoized(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if((ctx->memo == NULL) || !shouldMemoize(rule)) {
+		return parseRule(rule, ctx, str, result_ret);
+	}
+
+	size_t offset = str - ctx->input;
+	uint32_t ruleIndex = Rule_GetIndex(rule);
+
+	ParseMemoEntry* entry = ParseMemo_Lookup(ctx->memo, offset, ruleIndex);
+
+	if(entry != NULL) {
+		// The entry's bytes weren't read again, so this doesn't go through ParseContext_MarkExamined.
+		if(offset + entry->examinedLen > ctx->examinedEnd) {
+			ctx->examinedEnd = offset + entry->examinedLen;
+		}
+		return setParseResultWithCut(result_ret, entry->success, entry->success? str : NULL, entry->length, entry->cut);
+	}
+
+	// Measure what this rule looks at on its own, then fold it back into the enclosing rule's range.
+	size_t outerExaminedEnd = ctx->examinedEnd;
+	ctx->examinedEnd = offset;
+
+	ParseResult result = parseRule(rule, ctx, str, result_ret);
+
+	// An aborted result only says where the parse was stopped.
+	if(ctx->abortReason != PARSE_NOT_ABORTED) {
+		return result;
+	}
+
+	ParseMemo_Store(ctx->memo, offset, (ParseMemoEntry) {
+		.ruleIndex = ruleIndex,
+		.success = result.success,
+		.cut = result.cut,
+		.length = result.length,
+		.examinedLen = ctx->examinedEnd - offset
+	});
+
+	if(outerExaminedEnd > ctx->examinedEnd) {
+		ctx->examinedEnd = outerExaminedEnd;
+	}
+
+	return result;
+}
+
+static ParseResult parseInstrumented(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	size_t offset = str - ctx->input;
+	ParseHeatmap* heatmap = ctx->heatmap;
+	uint32_t outerRule = 0;
+	uint32_t outerChoiceRule = 0;
+
+	if(ctx->trace != NULL) {
+		ParseTrace_Record(ctx->trace, rule, false, offset, 0, false);
+	}
+	if(heatmap != NULL) {
+		outerRule = heatmap->currentRule;
+		outerChoiceRule = heatmap->currentChoiceRule;
+		ParseHeatmap_EnterRule(heatmap, rule);
+	}
+
+	ParseEvents* events = ctx->events;
+	size_t pendingMark = 0;
+	bool eventsOk = true;
+	ParseResult result;
+
+	if(events != NULL) {
+		pendingMark = ParseEvents_Enter(events, rule, offset, &eventsOk);
+	}
+
+	// A memoized result would skip the events of the rules inside.
+	if((events != NULL) && ParseEvents_NeedsChildren(events, rule)) {
+		result = parseRule(rule, ctx, str, result_ret);
+	} else {
+		result = parseMemoized(rule, ctx, str, result_ret);
+	}
+
+	if((events != NULL) && !(ParseEvents_Exit(events, rule, offset, &result, pendingMark) && eventsOk)) {
+		ctx->abortReason = PARSE_ABORTED_BY_CALLBACK;
+	}
+
+	if(heatmap != NULL) {
+		heatmap->currentRule = outerRule;
+		heatmap->currentChoiceRule = outerChoiceRule;
+	}
+	if(ctx->trace != NULL) {
+		ParseTrace_Record(ctx->trace, rule, true, offset, result.length, result.success);
+	}
+
+	return result;
+}
+
+static ParseResult abortParse(ParseResult* result_ret) {
+	ParseResult result = setParseResult(result_ret, false, NULL, 0);
+	result.aborted = true;
+
+	if(result_ret != NULL) {
+		(*result_ret) = result;
+	}
+
+	return result;
+}
+
+ParseResult Rule_ParseWithContext(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	if((++ctx->numSteps >= ctx->nextLimitCheck) && !checkParseLimits(ctx)) {
+		return abortParse(result_ret);
+	}
+
+	ParseResult result = ((ctx->trace == NULL) && (ctx->heatmap == NULL) && (ctx->events == NULL))?
+		parseMemoized(rule, ctx, str, result_ret) :
+		parseInstrumented(rule, ctx, str, result_ret);
+
+	if(ctx->abortReason != PARSE_NOT_ABORTED) {
+		return abortParse(result_ret);
+	}
+
+	return result;
+}
+
 void Rule_PrintSimpleRulePointer(ParseRule* rule, FILE* fout) {
 	if(rule == NULL) {
 		fprintf(fout, "NULL");
@@ -222,31 +1040,16 @@ void Rule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth,
 		fprintf(fout, "(forward) ");
 	}
 
-	switch(rule->ruleType) {
-		case PARSE_RULE_ALPHABET:
-			AlphabetRule_Print(rule->alphabetRule, fout);
-			break;
-		case PARSE_RULE_OPTION_LIST:
-			OptionListRule_PrintDeep(rule->optionListRule, fout, depth, maxDepth, indentStr);
-			break;
-		case PARSE_RULE_SEQUENCE:
-			SequenceRule_PrintDeep(rule->sequenceRule, fout, depth, maxDepth, indentStr);
-			break;
-		case PARSE_RULE_FORWARD_DECLARED:
-			ForwardRule_Print(rule, fout);
-			break;
-		case PARSE_RULE_STRING:
-			StringRule_Print(rule->stringRule, fout);
-			break;
-		case PARSE_RULE_OPTIONAL:
-			OptionalRule_PrintDeep(rule->optionalRule, fout, depth, maxDepth, indentStr);
-			break;
-		case PARSE_RULE_REPEAT:
-			RepeatRule_PrintDeep(rule->repeatRule, fout, depth, maxDepth, indentStr);
-			break;
-		default:
-			fprintf(fout, "Unknown Rule Type\n");
-			break;
+	if(rule->hasDfa) {
+		fprintf(fout, "(dfa: %lu states) ", Rule_GetDfa(rule)->numStates);
+	}
+
+	ParseRuleVTable* vtable = &ruleVTables[rule->ruleType];
+
+	if(vtable->printDeep != NULL) {
+		vtable->printDeep(rule, fout, depth, maxDepth, indentStr);
+	} else {
+		vtable->print(rule, fout);
 	}
 }
 
@@ -255,10 +1058,16 @@ void Rule_Print(ParseRule* rule, FILE* fout) {
 }
 
 ParseResult setParseResult(ParseResult* ptr, bool success, char* str, size_t length) {
+	return setParseResultWithCut(ptr, success, str, length, false);
+}
+
+ParseResult setParseResultWithCut(ParseResult* ptr, bool success, char* str, size_t length, bool cut) {
 	ParseResult result = {
 		.success = success,
 		.str = str,
-		.length = length
+		.length = length,
+		.cut = cut,
+		.aborted = false
 	};
 	
 	if(ptr != NULL) {
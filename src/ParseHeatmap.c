@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseHeatmap.h"
+
+ParseHeatmap* ParseHeatmap_Create(ParseScheme* scheme, size_t inputLen) {
+	if(scheme == NULL) {
+		fprintf(stderr, "Error: attempting to create a heatmap for a null scheme.\n");
+		return NULL;
+	}
+
+	ParseHeatmap* ret = (ParseHeatmap*) malloc(sizeof(ParseHeatmap));
+	uint32_t* readCounts = (uint32_t*) calloc(inputLen + 1, sizeof(uint32_t));
+	uint32_t* topRules = (uint32_t*) malloc(sizeof(uint32_t) * (inputLen + 1));
+	uint32_t* topRuleVotes = (uint32_t*) calloc(inputLen + 1, sizeof(uint32_t));
+	ParseHeatmapRuleStats* ruleStats = (ParseHeatmapRuleStats*) calloc(scheme->numRules + 1, sizeof(ParseHeatmapRuleStats));
+
+	if((ret == NULL) || (readCounts == NULL) || (topRules == NULL) || (topRuleVotes == NULL) || (ruleStats == NULL)) {
+		fprintf(stderr, "Error: unable to allocate parse heatmap!\n");
+		free(ret);
+		free(readCounts);
+		free(topRules);
+		free(topRuleVotes);
+		free(ruleStats);
+		return NULL;
+	}
+
+	for(size_t i = 0; i <= inputLen; i++) {
+		topRules[i] = UINT32_MAX;
+	}
+
+	(*ret) = (ParseHeatmap) {
+		.scheme = scheme,
+		.inputLen = inputLen,
+		.readCounts = readCounts,
+		.topRules = topRules,
+		.topRuleVotes = topRuleVotes,
+		.ruleStats = ruleStats,
+		.numRules = scheme->numRules,
+		.totalReads = 0,
+		.currentRule = UINT32_MAX,
+		.currentChoiceRule = UINT32_MAX
+	};
+
+	return ret;
+}
+
+void ParseHeatmap_Free(ParseHeatmap* heatmap) {
+	if(heatmap == NULL) {
+		return;
+	}
+
+	free(heatmap->readCounts);
+	free(heatmap->topRules);
+	free(heatmap->topRuleVotes);
+	free(heatmap->ruleStats);
+	free(heatmap);
+}
+
+static bool isLeafRule(ParseRule* rule) {
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+		case PARSE_RULE_STRING:
+		case PARSE_RULE_CUT:
+		case PARSE_RULE_TOKEN:
+		case PARSE_RULE_SKIP:
+		case PARSE_RULE_SCAN_UNTIL:
+			return true;
+		default:
+			return rule->hasDfa;
+	}
+}
+
+void ParseHeatmap_EnterRule(ParseHeatmap* heatmap, ParseRule* rule) {
+	if(rule->scheme != heatmap->scheme) {
+		heatmap->currentRule = UINT32_MAX;
+		return;
+	}
+
+	uint32_t index = Rule_GetIndex(rule);
+
+	heatmap->currentRule = index;
+	if(index < heatmap->numRules) {
+		heatmap->ruleStats[index].attempts++;
+	}
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_OPTION_LIST:
+			heatmap->currentChoiceRule = index;
+			break;
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT: {
+			// When a single leaf fails, it only gives up the lookahead it needed to fail, so only rules around
+			// something bigger are where a parse can backtrack over a lot of input.
+			ParseRule* innerRule = Rule_GetInnerRule(rule);
+			if(!isLeafRule(innerRule)) {
+				heatmap->currentChoiceRule = index;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void ParseHeatmap_Record(ParseHeatmap* heatmap, size_t offset, size_t len) {
+	if(offset > heatmap->inputLen) {
+		return;
+	}
+	if(len > heatmap->inputLen + 1 - offset) {
+		len = heatmap->inputLen + 1 - offset;
+	}
+
+	heatmap->totalReads += len;
+
+	if(heatmap->currentRule < heatmap->numRules) {
+		heatmap->ruleStats[heatmap->currentRule].bytesRead += len;
+	}
+
+	uint32_t choiceRule = heatmap->currentChoiceRule;
+	if(choiceRule < heatmap->numRules) {
+		heatmap->ruleStats[choiceRule].bytesReadUnder += len;
+	}
+
+	for(size_t i = offset; i < offset + len; i++) {
+		heatmap->readCounts[i]++;
+
+		// Boyer-Moore majority vote: if one rule was behind most of the reads, it ends up as the top rule.
+		if(heatmap->topRules[i] == choiceRule) {
+			heatmap->topRuleVotes[i]++;
+		} else if(heatmap->topRuleVotes[i] == 0) {
+			heatmap->topRules[i] = choiceRule;
+			heatmap->topRuleVotes[i] = 1;
+		} else {
+			heatmap->topRuleVotes[i]--;
+		}
+	}
+}
+
+double ParseHeatmap_GetAmplification(ParseHeatmap* heatmap) {
+	if(heatmap->inputLen == 0) {
+		return (double) heatmap->totalReads;
+	}
+
+	return (double) heatmap->totalReads / (double) heatmap->inputLen;
+}
+
+static void printRule(ParseHeatmap* heatmap, uint32_t index, FILE* fout) {
+	if(index >= heatmap->scheme->numRules) {
+		fprintf(fout, "(none)");
+		return;
+	}
+
+	Rule_Print(heatmap->scheme->rules + index, fout);
+}
+
+static int compareRuleReads(const void* a, const void* b) {
+	const ParseHeatmapRuleStats* statsA = *(const ParseHeatmapRuleStats**) a;
+	const ParseHeatmapRuleStats* statsB = *(const ParseHeatmapRuleStats**) b;
+
+	size_t readsA = statsA->bytesReadUnder + statsA->bytesRead;
+	size_t readsB = statsB->bytesReadUnder + statsB->bytesRead;
+
+	return (readsA < readsB) - (readsA > readsB);
+}
+
+void ParseHeatmap_PrintReport(ParseHeatmap* heatmap, FILE* fout, size_t maxHotspots, size_t maxRules) {
+	if(heatmap == NULL) {
+		fprintf(fout, "Heatmap is null!\n");
+		return;
+	}
+
+	fprintf(fout, "Input length: %lu, bytes examined: %lu, amplification: %.2f\n",
+		heatmap->inputLen, heatmap->totalReads, ParseHeatmap_GetAmplification(heatmap));
+
+	// Keep the most read offsets sorted, most read first.
+	size_t* hotspots = (size_t*) malloc(sizeof(size_t) * (maxHotspots + 1));
+	ParseHeatmapRuleStats** sortedStats = (ParseHeatmapRuleStats**) malloc(sizeof(ParseHeatmapRuleStats*) * (heatmap->numRules + 1));
+
+	if((hotspots == NULL) || (sortedStats == NULL)) {
+		fprintf(stderr, "Error: unable to allocate heatmap report!\n");
+		free(hotspots);
+		free(sortedStats);
+		return;
+	}
+
+	size_t numHotspots = 0;
+
+	for(size_t i = 0; (i <= heatmap->inputLen) && (maxHotspots > 0); i++) {
+		uint32_t count = heatmap->readCounts[i];
+		if((count == 0) || ((numHotspots == maxHotspots) && (count <= heatmap->readCounts[hotspots[numHotspots - 1]]))) {
+			continue;
+		}
+
+		size_t j = (numHotspots < maxHotspots)? numHotspots++ : numHotspots - 1;
+		while((j > 0) && (heatmap->readCounts[hotspots[j - 1]] < count)) {
+			hotspots[j] = hotspots[j - 1];
+			j--;
+		}
+		hotspots[j] = i;
+	}
+
+	fprintf(fout, "\nHotspots:\n");
+	for(size_t i = 0; i < numHotspots; i++) {
+		size_t offset = hotspots[i];
+		fprintf(fout, "  offset %lu%s: read %u times, mostly under ", offset,
+			(offset == heatmap->inputLen)? " (end of input)" : "", heatmap->readCounts[offset]);
+		printRule(heatmap, heatmap->topRules[offset], fout);
+		fprintf(fout, "\n");
+	}
+
+	for(size_t i = 0; i < heatmap->numRules; i++) {
+		sortedStats[i] = heatmap->ruleStats + i;
+	}
+	qsort(sortedStats, heatmap->numRules, sizeof(ParseHeatmapRuleStats*), compareRuleReads);
+
+	fprintf(fout, "\nRules (attempts, bytes read, bytes read under):\n");
+	for(size_t i = 0; (i < heatmap->numRules) && (i < maxRules); i++) {
+		ParseHeatmapRuleStats* stats = sortedStats[i];
+		if((stats->attempts == 0) && (stats->bytesRead == 0)) {
+			break;
+		}
+
+		fprintf(fout, "  %lu, %lu, %lu (%.1f%%): ", stats->attempts, stats->bytesRead, stats->bytesReadUnder,
+			(heatmap->totalReads == 0)? 0.0 : 100.0 * (double) stats->bytesReadUnder / (double) heatmap->totalReads);
+		printRule(heatmap, (uint32_t) (stats - heatmap->ruleStats), fout);
+		fprintf(fout, "\n");
+	}
+
+	free(hotspots);
+	free(sortedStats);
+}
@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "ParseFramework.h"
+#include "RuleAnalysis.h"
+#include "SimdUtil.h"
+#include "ParseLint.h"
+
+const size_t PARSE_LINT_ISSUES_BUFFER_LENGTH = 16;
+
+static const char* PARSE_LINT_DESCRIPTIONS[] = {
+	[PARSE_LINT_NULLABLE_REPEAT] = "repeats a rule that can match the empty string, so it never stops",
+	[PARSE_LINT_LEFT_RECURSION] = "is left recursive, so it never stops",
+	[PARSE_LINT_UNREACHABLE_OPTION] = "has an option that can't match, since an earlier option always matches first",
+	[PARSE_LINT_EXPONENTIAL_BACKTRACKING] = "backtracks exponentially on nested input",
+	[PARSE_LINT_EXPENSIVE_BACKTRACKING] = "backtracks over the same input many times"
+};
+
+static bool addIssue(ParseLintReport* report, ParseLintIssueType type, bool isError, uint32_t ruleIndex, uint32_t otherRuleIndex) {
+	if(report->numIssues == report->maxIssues) {
+		size_t newLength = report->maxIssues * 2 + PARSE_LINT_ISSUES_BUFFER_LENGTH;
+		ParseLintIssue* newIssues = (ParseLintIssue*) realloc(report->issues, sizeof(ParseLintIssue) * newLength);
+
+		if(newIssues == NULL) {
+			fprintf(stderr, "Error: unable to allocate space for lint issues!\n");
+			return false;
+		}
+
+		report->issues = newIssues;
+		report->maxIssues = newLength;
+	}
+
+	report->issues[report->numIssues++] = (ParseLintIssue) {
+		.type = type,
+		.isError = isError,
+		.ruleIndex = ruleIndex,
+		.otherRuleIndex = otherRuleIndex
+	};
+	if(isError) {
+		report->numErrors++;
+	}
+
+	return true;
+}
+
+// Rules that depend on a custom type without a FIRST set are assumed to be nullable, which is too much of a
+// guess to report anything from, so only rules that are known to be nullable count.
+static bool isNullable(ParseRule* rule) {
+	ByteSet first;
+	bool known;
+	bool nullable = Rule_GetFirstSetIfKnown(rule, &first, &known);
+	return nullable && known;
+}
+
+// Whether costs depend on guesses: options of unknown types can't be told apart from the options next to
+// them, so they are assumed to read the same input.
+static bool hasUnknownRules(ParseScheme* scheme) {
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		const ParseRuleVTable* vtable = ParseRuleType_GetVTable(scheme->rules[i].ruleType);
+		if((scheme->rules[i].ruleType >= PARSE_RULE_NUM_BUILTIN_TYPES) && ((vtable == NULL) || (vtable->getFirstSet == NULL))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// =================================
+// Repeats and options
+// =================================
+
+// Whether every match of option starts with a match of the single-token rule earlier, in which case earlier
+// always matches first.
+static bool alwaysMatchesFirst(ParseRule* earlier, ParseRule* option) {
+	char prefix[64];
+	size_t prefixLen = Rule_GetLiteralPrefix(option, prefix, sizeof(prefix));
+
+	switch(earlier->ruleType) {
+		case PARSE_RULE_STRING: {
+			size_t len = earlier->stringRule.stringLen;
+			if((len == 0) || (len > prefixLen)) {
+				return false;
+			}
+			if(earlier->stringRule.caseInsensitive) {
+				return SimdUtil_EqualsFolded(prefix, Rule_GetText(earlier), len);
+			}
+			return memcmp(prefix, Rule_GetText(earlier), len) == 0;
+		}
+		case PARSE_RULE_ALPHABET:
+			if(prefixLen == 0) {
+				return false;
+			}
+			for(size_t i = 0; i < earlier->alphabetRule.alphabetLen; i++) {
+				char c = earlier->alphabetRule.caseInsensitive? (char) SIMD_FOLD_ASCII_CASE(prefix[0]) : prefix[0];
+				if(Rule_GetText(earlier)[i] == c) {
+					return true;
+				}
+			}
+			return false;
+		default:
+			return false;
+	}
+}
+
+static bool lintRule(ParseLintReport* report, ParseRule* rule) {
+	uint32_t index = Rule_GetIndex(rule);
+
+	if(rule->wasForwardDeclaration) {
+		return true;
+	}
+
+	if((rule->ruleType == PARSE_RULE_REPEAT) && (rule->repeatRule.maxReps == SIZE_MAX) && isNullable(Rule_GetInnerRule(rule))) {
+		return addIssue(report, PARSE_LINT_NULLABLE_REPEAT, true, index, rule->repeatRule.rule);
+	}
+
+	if(rule->ruleType != PARSE_RULE_OPTION_LIST) {
+		return true;
+	}
+
+	for(size_t j = 1; j < rule->optionListRule.rulesLen; j++) {
+		ParseRule* option = Rule_GetListRule(rule, j);
+
+		for(size_t i = 0; i < j; i++) {
+			ParseRule* earlier = Rule_GetListRule(rule, i);
+
+			if(isNullable(earlier) || alwaysMatchesFirst(earlier, option)) {
+				if(!addIssue(report, PARSE_LINT_UNREACHABLE_OPTION, false, index, Rule_GetIndex(option))) {
+					return false;
+				}
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+// =================================
+// Left recursion
+// =================================
+
+typedef struct {
+	ParseLintReport* report;
+	const bool* checked;
+	// 0 if the rule hasn't been visited, 1 while its left calls are being walked, 2 once they have been.
+	uint8_t* states;
+	bool ok;
+} LeftRecursionSearch;
+
+static void findLeftRecursion(LeftRecursionSearch* search, uint32_t index);
+
+static bool visitLeftCall(LeftRecursionSearch* search, ParseRule* from, ParseRule* to) {
+	uint32_t toIndex = Rule_GetIndex(to);
+
+	if(search->states[toIndex] == 1) {
+		bool isChecked = (search->checked == NULL) || search->checked[toIndex];
+		search->ok = search->ok && (!isChecked || addIssue(search->report, PARSE_LINT_LEFT_RECURSION, true, toIndex, Rule_GetIndex(from)));
+	} else if(search->states[toIndex] == 0) {
+		findLeftRecursion(search, toIndex);
+	}
+
+	return search->ok;
+}
+
+// Walks the rules that can be parsed at the same offset as the rule itself.
+static void findLeftRecursion(LeftRecursionSearch* search, uint32_t index) {
+	ParseRule* rule = search->report->scheme->rules + index;
+	search->states[index] = 1;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_SEQUENCE:
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				ParseRule* element = Rule_GetListRule(rule, i);
+				if(!visitLeftCall(search, rule, element) || !isNullable(element)) {
+					break;
+				}
+			}
+			break;
+		case PARSE_RULE_OPTION_LIST:
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				if(!visitLeftCall(search, rule, Rule_GetListRule(rule, i))) {
+					break;
+				}
+			}
+			break;
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT:
+			visitLeftCall(search, rule, Rule_GetInnerRule(rule));
+			break;
+		case PARSE_RULE_LAZY:
+			if(rule->lazyRule.skipRule != UINT32_MAX) {
+				visitLeftCall(search, rule, search->report->scheme->rules + rule->lazyRule.skipRule);
+			}
+			break;
+		case PARSE_RULE_OPERATOR_PRECEDENCE: {
+			// Infix and postfix operators come after an operand, which only leaves them at the same offset if
+			// the operand can be empty.
+			ParseRule* operand = Rule_GetOperandRule(rule);
+			if(!visitLeftCall(search, rule, operand)) {
+				break;
+			}
+			bool nullable = isNullable(operand);
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				if((nullable || (Rule_GetOperatorKind(rule, i) == PARSE_OPERATOR_PREFIX)) && !visitLeftCall(search, rule, Rule_GetOperatorRule(rule, i))) {
+					break;
+				}
+			}
+			break;
+		}
+		case PARSE_RULE_SEPARATED_LIST:
+			if(visitLeftCall(search, rule, Rule_GetItemRule(rule)) && isNullable(Rule_GetItemRule(rule))) {
+				visitLeftCall(search, rule, Rule_GetSeparatorRule(rule));
+			}
+			break;
+		default:
+			break;
+	}
+
+	search->states[index] = 2;
+}
+
+// =================================
+// Backtracking cost
+// =================================
+
+static size_t addCosts(size_t a, size_t b) {
+	return (a > SIZE_MAX - b)? SIZE_MAX : a + b;
+}
+
+static size_t maxCost(size_t a, size_t b) {
+	return (a > b)? a : b;
+}
+
+// Every byte is read once by the rule that matches it. A failed option has read some of the bytes that the
+// options after it read again, which only matters if they could match the same input.
+static size_t getRuleCost(ParseScheme* scheme, ParseRule* rule, const size_t* costs) {
+	if(rule->hasDfa) {
+		return 1;
+	}
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_SEQUENCE: {
+			size_t cost = 1;
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				cost = maxCost(cost, costs[Rule_GetIndex(Rule_GetListRule(rule, i))]);
+			}
+			return cost;
+		}
+		case PARSE_RULE_OPTION_LIST: {
+			size_t cost = 1;
+			for(size_t j = 0; j < rule->optionListRule.rulesLen; j++) {
+				ParseRule* option = Rule_GetListRule(rule, j);
+				size_t optionCost = costs[Rule_GetIndex(option)];
+
+				for(size_t i = 0; i < j; i++) {
+					ParseRule* earlier = Rule_GetListRule(rule, i);
+					if(!Rule_AreMutuallyExclusive(earlier, option)) {
+						optionCost = addCosts(optionCost, costs[Rule_GetIndex(earlier)]);
+					}
+				}
+				cost = maxCost(cost, optionCost);
+			}
+			return cost;
+		}
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT:
+			return costs[Rule_GetIndex(Rule_GetInnerRule(rule))];
+		case PARSE_RULE_LAZY:
+			return (rule->lazyRule.skipRule == UINT32_MAX)? 1 : costs[rule->lazyRule.skipRule];
+		case PARSE_RULE_OPERATOR_PRECEDENCE: {
+			// When the rest of an expression fails after a prefix operator, the operand is tried in its place.
+			ParseRule* operand = Rule_GetOperandRule(rule);
+			size_t cost = costs[Rule_GetIndex(operand)];
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				ParseRule* op = Rule_GetOperatorRule(rule, i);
+				size_t opCost = costs[Rule_GetIndex(op)];
+				if((Rule_GetOperatorKind(rule, i) == PARSE_OPERATOR_PREFIX) && !Rule_AreMutuallyExclusive(op, operand)) {
+					opCost = addCosts(opCost, costs[Rule_GetIndex(operand)]);
+				}
+				cost = maxCost(cost, opCost);
+			}
+			return cost;
+		}
+		case PARSE_RULE_SEPARATED_LIST:
+			return maxCost(costs[rule->separatedListRule.item], costs[rule->separatedListRule.separator]);
+		default:
+			return 1;
+	}
+}
+
+static bool updateCosts(ParseScheme* scheme, size_t* costs, bool* changed_ret) {
+	bool changed = false;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		size_t cost = getRuleCost(scheme, scheme->rules + i, costs);
+		if(cost > costs[i]) {
+			costs[i] = cost;
+			changed_ret[i] = true;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+// Costs only depend on each other through recursion. Recursion that goes through max() settles within a
+// couple of passes over the rules, but recursion that adds keeps growing: by a constant on every trip around
+// the cycle if the rule is added to something else, or doubling if it's added to itself.
+static bool findCosts(ParseScheme* scheme, size_t* costs, bool* growsWithDepth) {
+	size_t numRules = scheme->numRules;
+	bool* changed = (bool*) calloc(numRules + 1, sizeof(bool));
+	size_t* before = (size_t*) malloc(sizeof(size_t) * (numRules + 1));
+
+	if((changed == NULL) || (before == NULL)) {
+		fprintf(stderr, "Error: unable to allocate space to estimate rule costs!\n");
+		free(changed);
+		free(before);
+		return false;
+	}
+
+	for(size_t i = 0; i < numRules; i++) {
+		costs[i] = 1;
+	}
+
+	bool growing = true;
+	for(size_t pass = 0; growing && (pass < 4 * numRules + 8); pass++) {
+		growing = updateCosts(scheme, costs, changed);
+	}
+
+	// Every cycle is gone around at least once in numRules + 1 passes. Costs that grow by a constant each
+	// time have grown by much less than that by now, but those that double have doubled.
+	if(growing) {
+		memcpy(before, costs, sizeof(size_t) * numRules);
+		memset(changed, 0, sizeof(bool) * numRules);
+
+		for(size_t pass = 0; pass < numRules + 1; pass++) {
+			updateCosts(scheme, costs, changed);
+		}
+
+		for(size_t i = 0; i < numRules; i++) {
+			if(!changed[i]) {
+				continue;
+			}
+
+			if((costs[i] == SIZE_MAX) || (costs[i] / 2 >= before[i])) {
+				costs[i] = SIZE_MAX;
+			} else {
+				growsWithDepth[i] = true;
+			}
+		}
+	}
+
+	free(changed);
+	free(before);
+	return true;
+}
+
+ParseLintReport* ParseScheme_Lint(ParseScheme* scheme) {
+	return ParseScheme_LintRules(scheme, NULL);
+}
+
+ParseLintReport* ParseScheme_LintRules(ParseScheme* scheme, const bool* checked) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		fprintf(stderr, "Error: attempting to lint a null scheme or one with an error.\n");
+		return NULL;
+	}
+
+	ParseLintReport* ret = (ParseLintReport*) malloc(sizeof(ParseLintReport));
+	size_t* costs = (size_t*) malloc(sizeof(size_t) * (scheme->numRules + 1));
+	bool* growsWithDepth = (bool*) calloc(scheme->numRules + 1, sizeof(bool));
+	uint8_t* states = (uint8_t*) calloc(scheme->numRules + 1, sizeof(uint8_t));
+
+	if((ret == NULL) || (costs == NULL) || (growsWithDepth == NULL) || (states == NULL)) {
+		fprintf(stderr, "Error: unable to allocate lint report!\n");
+		free(ret);
+		free(costs);
+		free(growsWithDepth);
+		free(states);
+		return NULL;
+	}
+
+	(*ret) = (ParseLintReport) {
+		.scheme = scheme,
+		.issues = NULL,
+		.numIssues = 0,
+		.maxIssues = 0,
+		.numErrors = 0,
+		.costs = costs,
+		.growsWithDepth = growsWithDepth
+	};
+
+	bool ok = true;
+
+	for(size_t i = 0; ok && (i < scheme->numRules); i++) {
+		if((checked == NULL) || checked[i]) {
+			ok = lintRule(ret, scheme->rules + i);
+		}
+	}
+
+	LeftRecursionSearch search = { .report = ret, .checked = checked, .states = states, .ok = ok };
+	for(size_t i = 0; search.ok && (i < scheme->numRules); i++) {
+		if(states[i] == 0) {
+			findLeftRecursion(&search, (uint32_t) i);
+		}
+	}
+	ok = search.ok;
+
+	// Costs mean nothing when a parse never stops, so they're only estimated once the rules can be parsed.
+	bool canEstimateCosts = (ret->numErrors == 0);
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		costs[i] = 1;
+	}
+	if(ok && canEstimateCosts) {
+		ok = findCosts(scheme, costs, growsWithDepth);
+	}
+
+	// Only the rules where the cost comes from are reported, not every rule that contains them. A resolved
+	// forward rule is a copy of another rule, which gets reported instead. Exponential costs are only errors
+	// if they don't rest on guesses.
+	bool costsAreGuesses = hasUnknownRules(scheme);
+	for(size_t i = 0; ok && (i < scheme->numRules); i++) {
+		ParseRule* rule = scheme->rules + i;
+		if((rule->ruleType != PARSE_RULE_OPTION_LIST) || rule->wasForwardDeclaration || ((checked != NULL) && !checked[i])) {
+			continue;
+		}
+		if((costs[i] <= PARSE_LINT_EXPENSIVE_COST) && !growsWithDepth[i]) {
+			continue;
+		}
+
+		if(costs[i] == SIZE_MAX) {
+			ok = addIssue(ret, PARSE_LINT_EXPONENTIAL_BACKTRACKING, !costsAreGuesses, (uint32_t) i, UINT32_MAX);
+		} else {
+			ok = addIssue(ret, PARSE_LINT_EXPENSIVE_BACKTRACKING, false, (uint32_t) i, UINT32_MAX);
+		}
+	}
+
+	free(states);
+
+	if(!ok) {
+		ParseLintReport_Free(ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+void ParseLintReport_Free(ParseLintReport* report) {
+	if(report == NULL) {
+		return;
+	}
+
+	free(report->issues);
+	free(report->costs);
+	free(report->growsWithDepth);
+	free(report);
+}
+
+void ParseLintReport_Print(ParseLintReport* report, FILE* fout) {
+	if((report == NULL) || (fout == NULL)) {
+		return;
+	}
+
+	fprintf(fout, "Lint found %zu errors and %zu warnings.\n", report->numErrors, report->numIssues - report->numErrors);
+
+	for(size_t i = 0; i < report->numIssues; i++) {
+		ParseLintIssue* issue = &report->issues[i];
+		ParseRule* rule = report->scheme->rules + issue->ruleIndex;
+
+		fprintf(fout, "%s: ", issue->isError? "error" : "warning");
+		Rule_PrintSimpleRulePointer(rule, fout);
+		fprintf(fout, " %s", PARSE_LINT_DESCRIPTIONS[issue->type]);
+
+		if((issue->type == PARSE_LINT_EXPENSIVE_BACKTRACKING) || (issue->type == PARSE_LINT_EXPONENTIAL_BACKTRACKING)) {
+			if(report->costs[issue->ruleIndex] == SIZE_MAX) {
+				fprintf(fout, " (memoize it, or factor out its options' common prefixes)");
+			} else if(report->growsWithDepth[issue->ruleIndex]) {
+				fprintf(fout, " (more times the deeper the input nests)");
+			} else {
+				fprintf(fout, " (up to %zu times)", report->costs[issue->ruleIndex]);
+			}
+		} else if(issue->otherRuleIndex != UINT32_MAX) {
+			fprintf(fout, " (");
+			Rule_PrintSimpleRulePointer(report->scheme->rules + issue->otherRuleIndex, fout);
+			fprintf(fout, ")");
+		}
+
+		fprintf(fout, "\n\t");
+		Rule_Print(rule, fout);
+		fprintf(fout, "\n");
+	}
+}
@@ -0,0 +1,389 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "ParseMemo.h"
+
+const size_t PARSE_MEMO_BUFFER_LENGTH = 256;
+const size_t PARSE_MEMO_COLUMN_BUFFER_LENGTH = 2;
+
+static void addBytes(ParseMemo* memo, size_t bytes) {
+	memo->currentBytes += bytes;
+
+	if(memo->currentBytes > memo->peakBytes) {
+		memo->peakBytes = memo->currentBytes;
+	}
+}
+
+ParseMemo* ParseMemo_Create(size_t inputLen) {
+	ParseMemo* ret = (ParseMemo*) malloc(sizeof(ParseMemo));
+
+	if(ret == NULL) {
+		fprintf(stderr, "Error: unable to allocate parse memo!\n");
+		return NULL;
+	}
+
+	ret->columns = NULL;
+	ret->maxColumns = 0;
+	ret->firstColumn = 0;
+	ret->gapStart = 0;
+	ret->gapEnd = 0;
+	ret->endColumn = 0;
+	ret->hint = 0;
+	ret->inputLen = inputLen;
+	ret->budgetBytes = 0;
+	ret->currentBytes = 0;
+	ret->peakBytes = 0;
+	ret->numEvictions = 0;
+	ret->errorState = 0;
+
+	addBytes(ret, sizeof(ParseMemo));
+
+	return ret;
+}
+
+static void freeColumn(ParseMemo* memo, ParseMemoColumn* column) {
+	memo->currentBytes -= column->maxEntries * sizeof(ParseMemoEntry);
+	free(column->entries);
+	column->entries = NULL;
+}
+
+void ParseMemo_Free(ParseMemo* memo) {
+	if(memo == NULL) {
+		return;
+	}
+
+	for(size_t i = memo->firstColumn; i < memo->gapStart; i++) {
+		free(memo->columns[i].entries);
+	}
+	for(size_t i = memo->gapEnd; i < memo->endColumn; i++) {
+		free(memo->columns[i].entries);
+	}
+
+	free(memo->columns);
+	free(memo);
+}
+
+void ParseMemo_SetBudget(ParseMemo* memo, size_t budgetBytes) {
+	if(memo == NULL) {
+		return;
+	}
+
+	memo->budgetBytes = budgetBytes;
+}
+
+void ParseMemo_MemoryStats(ParseMemo* memo, ParseMemoryStats* stats_ret) {
+	if((memo == NULL) || (stats_ret == NULL)) {
+		return;
+	}
+
+	stats_ret->memoBytes += memo->currentBytes;
+	stats_ret->peakMemoBytes += memo->peakBytes;
+	stats_ret->numMemoEvictions += memo->numEvictions;
+	stats_ret->currentBytes += memo->currentBytes;
+	stats_ret->peakBytes += memo->peakBytes;
+}
+
+static size_t columnOffset(ParseMemo* memo, size_t index) {
+	return (index < memo->gapStart)? memo->columns[index].key : memo->inputLen - memo->columns[index].key;
+}
+
+// Moves the gap so that the columns before it are exactly those with offsets below the given one.
+static void moveGap(ParseMemo* memo, size_t offset) {
+	while((memo->gapStart > memo->firstColumn) && (columnOffset(memo, memo->gapStart - 1) >= offset)) {
+		memo->gapStart--;
+		memo->gapEnd--;
+		memo->columns[memo->gapEnd] = memo->columns[memo->gapStart];
+		memo->columns[memo->gapEnd].key = memo->inputLen - memo->columns[memo->gapEnd].key;
+	}
+
+	while((memo->gapEnd < memo->endColumn) && (columnOffset(memo, memo->gapEnd) < offset)) {
+		memo->columns[memo->gapStart] = memo->columns[memo->gapEnd];
+		memo->columns[memo->gapStart].key = memo->inputLen - memo->columns[memo->gapStart].key;
+		memo->gapStart++;
+		memo->gapEnd++;
+	}
+}
+
+// Evicts whichever of the first and last columns is farther from the offset, unless that is the column at
+// the offset itself. Returns whether a column was evicted.
+static bool evictFarthestColumn(ParseMemo* memo, size_t offset) {
+	bool hasBefore = (memo->gapStart > memo->firstColumn);
+	bool hasAfter = (memo->gapEnd < memo->endColumn);
+
+	if(!hasBefore && !hasAfter) {
+		return false;
+	}
+
+	size_t first = hasBefore? memo->firstColumn : memo->gapEnd;
+	size_t last = hasAfter? memo->endColumn - 1 : memo->gapStart - 1;
+
+	size_t firstOffset = columnOffset(memo, first);
+	size_t lastOffset = columnOffset(memo, last);
+	size_t firstDistance = (offset > firstOffset)? offset - firstOffset : 0;
+	size_t lastDistance = (lastOffset > offset)? lastOffset - offset : 0;
+
+	if((firstDistance == 0) && (lastDistance == 0)) {
+		return false;
+	}
+
+	if(firstDistance >= lastDistance) {
+		freeColumn(memo, memo->columns + first);
+		if(hasBefore) {
+			memo->firstColumn++;
+		} else {
+			memo->gapEnd++;
+		}
+	} else {
+		freeColumn(memo, memo->columns + last);
+		if(hasAfter) {
+			memo->endColumn--;
+		} else {
+			memo->gapStart--;
+		}
+	}
+
+	memo->numEvictions++;
+
+	return true;
+}
+
+static void evictToBudget(ParseMemo* memo, size_t offset) {
+	if(memo->budgetBytes == 0) {
+		return;
+	}
+
+	while((memo->currentBytes > memo->budgetBytes) && evictFarthestColumn(memo, offset)) {
+		// Keep going.
+	}
+}
+
+// Moves the free space at both ends of the buffer into the gap.
+static void compactColumns(ParseMemo* memo) {
+	size_t numBefore = memo->gapStart - memo->firstColumn;
+	size_t numAfter = memo->endColumn - memo->gapEnd;
+
+	memmove(memo->columns, memo->columns + memo->firstColumn, numBefore * sizeof(ParseMemoColumn));
+	memmove(memo->columns + memo->maxColumns - numAfter, memo->columns + memo->gapEnd, numAfter * sizeof(ParseMemoColumn));
+
+	memo->firstColumn = 0;
+	memo->gapStart = numBefore;
+	memo->gapEnd = memo->maxColumns - numAfter;
+	memo->endColumn = memo->maxColumns;
+}
+
+// Returns the first index in [low, high) whose column is at or after the offset, or high if there is none.
+// Parsing mostly moves forward a little at a time, so the search gallops out from the last column found.
+static size_t lowerBound(ParseMemo* memo, size_t low, size_t high, size_t offset) {
+	size_t hint = memo->hint;
+
+	if((hint >= low) && (hint < high)) {
+		if(columnOffset(memo, hint) < offset) {
+			low = hint + 1;
+			for(size_t step = 1; low < high; step *= 2) {
+				size_t probe = (high - low > step)? low + step - 1 : high - 1;
+				if(columnOffset(memo, probe) >= offset) {
+					high = probe + 1;
+					break;
+				}
+				low = probe + 1;
+			}
+		} else {
+			high = hint + 1;
+			for(size_t step = 1; low < high - 1; step *= 2) {
+				size_t probe = (high - 1 - low > step)? high - 1 - step : low;
+				if(columnOffset(memo, probe) < offset) {
+					low = probe + 1;
+					break;
+				}
+				high = probe + 1;
+			}
+		}
+	}
+
+	while(low < high) {
+		size_t mid = low + (high - low) / 2;
+		if(columnOffset(memo, mid) < offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+static ParseMemoColumn* findColumn(ParseMemo* memo, size_t offset) {
+	size_t index;
+
+	if((memo->gapStart > memo->firstColumn) && (offset <= memo->columns[memo->gapStart - 1].key)) {
+		index = lowerBound(memo, memo->firstColumn, memo->gapStart, offset);
+	} else {
+		index = lowerBound(memo, memo->gapEnd, memo->endColumn, offset);
+		if(index == memo->endColumn) {
+			return NULL;
+		}
+	}
+
+	memo->hint = index;
+
+	return (columnOffset(memo, index) == offset)? memo->columns + index : NULL;
+}
+
+static ParseMemoColumn* insertColumn(ParseMemo* memo, size_t offset) {
+	if(memo->gapStart == memo->gapEnd) {
+		size_t newMax = (memo->maxColumns == 0)? PARSE_MEMO_BUFFER_LENGTH : memo->maxColumns * 2;
+		size_t growth = (newMax - memo->maxColumns) * sizeof(ParseMemoColumn);
+
+		// Rather than growing past the budget, make room by evicting columns. Evicting an eighth of them at a
+		// time means the buffer only has to be compacted every so often.
+		if((memo->budgetBytes != 0) && (memo->currentBytes + growth > memo->budgetBytes)) {
+			size_t numToEvict = (memo->gapStart - memo->firstColumn + memo->endColumn - memo->gapEnd) / 8 + 1;
+			for(size_t i = 0; (i < numToEvict) && evictFarthestColumn(memo, offset); i++) {
+				// Keep going.
+			}
+		}
+
+		if((memo->firstColumn > 0) || (memo->endColumn < memo->maxColumns)) {
+			compactColumns(memo);
+		} else {
+			ParseMemoColumn* newColumns = (ParseMemoColumn*) realloc(memo->columns, newMax * sizeof(ParseMemoColumn));
+
+			if(newColumns == NULL) {
+				fprintf(stderr, "Error: unable to grow parse memo.\n");
+				memo->errorState = 1;
+				return NULL;
+			}
+
+			memo->columns = newColumns;
+			memo->maxColumns = newMax;
+			addBytes(memo, growth);
+
+			compactColumns(memo);
+		}
+	}
+
+	moveGap(memo, offset);
+
+	ParseMemoColumn* column = memo->columns + memo->gapStart;
+	memo->gapStart++;
+
+	(*column) = (ParseMemoColumn) {
+		.key = offset,
+		.entries = NULL,
+		.numEntries = 0,
+		.maxEntries = 0,
+		.maxExaminedLen = 0
+	};
+
+	return column;
+}
+
+ParseMemoEntry* ParseMemo_Lookup(ParseMemo* memo, size_t offset, uint32_t ruleIndex) {
+	ParseMemoColumn* column = findColumn(memo, offset);
+
+	if(column == NULL) {
+		return NULL;
+	}
+
+	for(size_t i = 0; i < column->numEntries; i++) {
+		if(column->entries[i].ruleIndex == ruleIndex) {
+			return column->entries + i;
+		}
+	}
+
+	return NULL;
+}
+
+bool ParseMemo_Store(ParseMemo* memo, size_t offset, ParseMemoEntry entry) {
+	if((memo == NULL) || (memo->errorState != 0)) {
+		return false;
+	}
+
+	ParseMemoColumn* column = findColumn(memo, offset);
+
+	if(column == NULL) {
+		column = insertColumn(memo, offset);
+		if(column == NULL) {
+			return false;
+		}
+	}
+
+	if(column->numEntries == column->maxEntries) {
+		size_t newMax = (column->maxEntries == 0)? PARSE_MEMO_COLUMN_BUFFER_LENGTH : column->maxEntries * 2;
+		ParseMemoEntry* newEntries = (ParseMemoEntry*) realloc(column->entries, newMax * sizeof(ParseMemoEntry));
+
+		if(newEntries == NULL) {
+			fprintf(stderr, "Error: unable to grow parse memo.\n");
+			memo->errorState = 1;
+			return false;
+		}
+
+		addBytes(memo, (newMax - column->maxEntries) * sizeof(ParseMemoEntry));
+		column->entries = newEntries;
+		column->maxEntries = newMax;
+	}
+
+	column->entries[column->numEntries++] = entry;
+
+	if(entry.examinedLen > column->maxExaminedLen) {
+		column->maxExaminedLen = entry.examinedLen;
+	}
+
+	evictToBudget(memo, offset);
+
+	return true;
+}
+
+void ParseMemo_DiscardBefore(ParseMemo* memo, size_t offset) {
+	if(memo == NULL) {
+		return;
+	}
+
+	moveGap(memo, offset);
+
+	for(size_t i = memo->firstColumn; i < memo->gapStart; i++) {
+		freeColumn(memo, memo->columns + i);
+	}
+	memo->gapStart = memo->firstColumn;
+}
+
+void ParseMemo_Edit(ParseMemo* memo, size_t offset, size_t removedLen, size_t insertedLen) {
+	if(memo == NULL) {
+		return;
+	}
+
+	// Columns after the removed bytes end up after the gap, where they move along with the end of the input.
+	moveGap(memo, offset + removedLen);
+
+	// Columns inside the removed bytes are gone.
+	while((memo->gapStart > memo->firstColumn) && (memo->columns[memo->gapStart - 1].key >= offset)) {
+		memo->gapStart--;
+		freeColumn(memo, memo->columns + memo->gapStart);
+	}
+
+	// Columns before the edit keep the entries that stopped looking before it.
+	for(size_t i = memo->firstColumn; i < memo->gapStart; i++) {
+		ParseMemoColumn* column = memo->columns + i;
+
+		if(column->key + column->maxExaminedLen <= offset) {
+			continue;
+		}
+
+		size_t numKept = 0;
+		column->maxExaminedLen = 0;
+
+		for(size_t j = 0; j < column->numEntries; j++) {
+			if(column->key + column->entries[j].examinedLen <= offset) {
+				if(column->entries[j].examinedLen > column->maxExaminedLen) {
+					column->maxExaminedLen = column->entries[j].examinedLen;
+				}
+				column->entries[numKept++] = column->entries[j];
+			}
+		}
+
+		column->numEntries = numKept;
+	}
+
+	memo->inputLen = memo->inputLen - removedLen + insertedLen;
+}
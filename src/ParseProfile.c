@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "RuleAnalysis.h"
+#include "ParseProfile.h"
+
+typedef struct {
+	uint32_t ruleIndex;
+	size_t matches;
+
+	// Only options that are non-nullable and can't cut before matching input can be swapped, and then only
+	// with another such option whose FIRST set is disjoint from theirs.
+	bool canSwap;
+	ByteSet first;
+} OptionInfo;
+
+ParseProfile* ParseProfile_Create(ParseScheme* scheme) {
+	if(scheme == NULL) {
+		fprintf(stderr, "Error: attempting to profile a null scheme.\n");
+		return NULL;
+	}
+
+	ParseProfile* ret = (ParseProfile*) malloc(sizeof(ParseProfile));
+	size_t* optionMatches = (size_t*) calloc(scheme->numChildIndices + 1, sizeof(size_t));
+
+	if((ret == NULL) || (optionMatches == NULL)) {
+		fprintf(stderr, "Error: unable to allocate parse profile!\n");
+		free(ret);
+		free(optionMatches);
+		return NULL;
+	}
+
+	(*ret) = (ParseProfile) {
+		.scheme = scheme,
+		.optionMatches = optionMatches,
+		.numOptions = scheme->numChildIndices
+	};
+
+	return ret;
+}
+
+void ParseProfile_Free(ParseProfile* profile) {
+	if(profile == NULL) {
+		return;
+	}
+
+	free(profile->optionMatches);
+	free(profile);
+}
+
+void ParseProfile_RecordOption(ParseProfile* profile, ParseRule* rule, size_t option) {
+	size_t index = rule->optionListRule.firstRule + option;
+
+	if((rule->scheme == profile->scheme) && (index < profile->numOptions)) {
+		profile->optionMatches[index]++;
+	}
+}
+
+static void getOptionInfo(ParseScheme* scheme, uint32_t ruleIndex, OptionInfo* info_ret) {
+	ParseRule* option = scheme->rules + ruleIndex;
+
+	info_ret->ruleIndex = ruleIndex;
+	info_ret->canSwap = !Rule_GetFirstSet(option, &info_ret->first) && !Rule_CanCutBeforeInput(option);
+}
+
+static bool canSwapOptions(OptionInfo* a, OptionInfo* b) {
+	return a->canSwap && b->canSwap && !ByteSet_Intersects(&a->first, &b->first);
+}
+
+// Gets the option lists that an order can be given to. A forward declared rule shares its options with the
+// rule it was set to, so only the latter is used.
+static bool canReorderRule(ParseRule* rule) {
+	return (rule->ruleType == PARSE_RULE_OPTION_LIST) && !rule->wasForwardDeclaration && (rule->optionListRule.rulesLen > 1);
+}
+
+size_t ParseScheme_ReorderOptions(ParseScheme* scheme, ParseProfile* profile) {
+	if((scheme == NULL) || (profile == NULL) || (scheme->errorState != 0) || (profile->scheme != scheme)) {
+		fprintf(stderr, "Error: attempting to reorder options with a null scheme or a profile of another scheme.\n");
+		return 0;
+	}
+
+	if(scheme->finalized) {
+		fprintf(stderr, "Error: attempting to reorder the options of a finalized scheme.\n");
+		return 0;
+	}
+
+	size_t numChanged = 0;
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+		if(!canReorderRule(rule)) {
+			continue;
+		}
+
+		size_t firstRule = rule->optionListRule.firstRule;
+		size_t numOptions = rule->optionListRule.rulesLen;
+
+		if(firstRule + numOptions > profile->numOptions) {
+			continue;
+		}
+
+		OptionInfo* options = (OptionInfo*) malloc(sizeof(OptionInfo) * numOptions);
+		if(options == NULL) {
+			fprintf(stderr, "Error: unable to allocate options to reorder!\n");
+			break;
+		}
+
+		for(size_t j = 0; j < numOptions; j++) {
+			getOptionInfo(scheme, scheme->childIndices[firstRule + j], &options[j]);
+			options[j].matches = profile->optionMatches[firstRule + j];
+		}
+
+		// An insertion sort, where each swap is between two options that can't match the same input, so the
+		// list still matches exactly what it did before.
+		bool changed = false;
+		for(size_t j = 1; j < numOptions; j++) {
+			for(size_t k = j; k > 0; k--) {
+				OptionInfo* before = &options[k - 1];
+				OptionInfo* after = &options[k];
+
+				if((after->matches <= before->matches) || !canSwapOptions(before, after)) {
+					break;
+				}
+
+				OptionInfo temp = (*before);
+				(*before) = (*after);
+				(*after) = temp;
+				changed = true;
+			}
+		}
+
+		if(changed) {
+			for(size_t j = 0; j < numOptions; j++) {
+				scheme->childIndices[firstRule + j] = options[j].ruleIndex;
+				profile->optionMatches[firstRule + j] = options[j].matches;
+			}
+			numChanged++;
+		}
+
+		free(options);
+	}
+
+	if(numChanged > 0) {
+		ParseScheme_RebuildInternTable(scheme);
+	}
+
+	return numChanged;
+}
+
+bool ParseScheme_SaveOptionOrder(ParseScheme* scheme, FILE* fout) {
+	if((scheme == NULL) || (fout == NULL) || (scheme->errorState != 0)) {
+		fprintf(stderr, "Error: attempting to save the option order of a null scheme or to a null file.\n");
+		return false;
+	}
+
+	fprintf(fout, "# Option order: option list rule index, then the rule indices of its options.\n");
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		ParseRule* rule = scheme->rules + i;
+		if(!canReorderRule(rule)) {
+			continue;
+		}
+
+		fprintf(fout, "%lu:", i);
+		for(size_t j = 0; j < rule->optionListRule.rulesLen; j++) {
+			fprintf(fout, " %u", scheme->childIndices[rule->optionListRule.firstRule + j]);
+		}
+		fprintf(fout, "\n");
+	}
+
+	return !ferror(fout);
+}
+
+// Checks that newOrder is the rule's options in an order that matches the same input, and writes it over them.
+static bool applyOptionOrder(ParseScheme* scheme, ParseRule* rule, uint32_t* newOrder, size_t numOptions) {
+	if(!canReorderRule(rule) || (rule->optionListRule.rulesLen != numOptions)) {
+		return false;
+	}
+
+	uint32_t* oldOrder = scheme->childIndices + rule->optionListRule.firstRule;
+
+	// Where each option is in the old order. An option that is in the list more than once is matched up with
+	// its occurrences in order.
+	size_t* oldPositions = (size_t*) malloc(sizeof(size_t) * numOptions);
+	bool* used = (bool*) calloc(numOptions, sizeof(bool));
+	OptionInfo* options = (OptionInfo*) malloc(sizeof(OptionInfo) * numOptions);
+	bool valid = (oldPositions != NULL) && (used != NULL) && (options != NULL);
+
+	for(size_t i = 0; valid && (i < numOptions); i++) {
+		valid = false;
+		for(size_t j = 0; j < numOptions; j++) {
+			if(!used[j] && (oldOrder[j] == newOrder[i])) {
+				used[j] = true;
+				oldPositions[i] = j;
+				valid = true;
+				break;
+			}
+		}
+	}
+
+	for(size_t i = 0; valid && (i < numOptions); i++) {
+		getOptionInfo(scheme, newOrder[i], &options[i]);
+	}
+
+	// Every pair of options that changed places has to be safe to swap.
+	for(size_t i = 0; valid && (i < numOptions); i++) {
+		for(size_t j = i + 1; valid && (j < numOptions); j++) {
+			if((oldPositions[i] > oldPositions[j]) && !canSwapOptions(&options[i], &options[j])) {
+				valid = false;
+			}
+		}
+	}
+
+	if(valid) {
+		memcpy(oldOrder, newOrder, sizeof(uint32_t) * numOptions);
+	}
+
+	free(oldPositions);
+	free(used);
+	free(options);
+
+	return valid;
+}
+
+size_t ParseScheme_LoadOptionOrder(ParseScheme* scheme, FILE* fin) {
+	if((scheme == NULL) || (fin == NULL) || (scheme->errorState != 0)) {
+		fprintf(stderr, "Error: attempting to load the option order of a null scheme or from a null file.\n");
+		return 0;
+	}
+
+	if(scheme->finalized) {
+		fprintf(stderr, "Error: attempting to reorder the options of a finalized scheme.\n");
+		return 0;
+	}
+
+	char* line = NULL;
+	size_t lineLen = 0;
+	uint32_t* order = NULL;
+	size_t maxOrderLen = 0;
+	size_t numChanged = 0;
+
+	while(getline(&line, &lineLen, fin) != -1) {
+		if((line[0] == '#') || (line[0] == '\n')) {
+			continue;
+		}
+
+		char* end;
+		size_t ruleIndex = strtoul(line, &end, 10);
+
+		if((end == line) || (*end != ':') || (ruleIndex >= scheme->numRules)) {
+			fprintf(stderr, "Error: skipping an option order that isn't for a rule in the scheme.\n");
+			continue;
+		}
+
+		size_t orderLen = 0;
+		bool valid = true;
+
+		for(char* next = end + 1; ; ) {
+			char* numberEnd;
+			unsigned long index = strtoul(next, &numberEnd, 10);
+			if(numberEnd == next) {
+				break;
+			}
+			next = numberEnd;
+
+			if(orderLen == maxOrderLen) {
+				size_t newLength = maxOrderLen * 2 + 16;
+				uint32_t* newOrder = (uint32_t*) realloc(order, sizeof(uint32_t) * newLength);
+				if(newOrder == NULL) {
+					valid = false;
+					break;
+				}
+				order = newOrder;
+				maxOrderLen = newLength;
+			}
+			order[orderLen++] = (uint32_t) index;
+		}
+
+		if(!valid || !applyOptionOrder(scheme, scheme->rules + ruleIndex, order, orderLen)) {
+			fprintf(stderr, "Error: skipping the option order for rule %lu, which doesn't fit it.\n", ruleIndex);
+			continue;
+		}
+
+		numChanged++;
+	}
+
+	free(line);
+	free(order);
+
+	if(numChanged > 0) {
+		ParseScheme_RebuildInternTable(scheme);
+	}
+
+	return numChanged;
+}
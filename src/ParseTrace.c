@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "ParseFramework.h"
+#include "ParseTrace.h"
+
+const size_t PARSE_TRACE_MIN_CAPACITY = 1024;
+
+static atomic_uint_fast32_t nextThreadId = 1;
+
+static uint64_t getTime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+}
+
+ParseTrace* ParseTrace_Create(ParseScheme* scheme, size_t capacity) {
+	if(scheme == NULL) {
+		fprintf(stderr, "Error: attempting to trace a null scheme.\n");
+		return NULL;
+	}
+
+	// A power of two, so that the ring can be indexed with a mask.
+	size_t roundedCapacity = PARSE_TRACE_MIN_CAPACITY;
+	while(roundedCapacity < capacity) {
+		roundedCapacity *= 2;
+	}
+
+	ParseTrace* ret = (ParseTrace*) malloc(sizeof(ParseTrace));
+	ParseTraceEvent* events = (ParseTraceEvent*) malloc(sizeof(ParseTraceEvent) * roundedCapacity);
+
+	if((ret == NULL) || (events == NULL)) {
+		fprintf(stderr, "Error: unable to allocate parse trace!\n");
+		free(ret);
+		free(events);
+		return NULL;
+	}
+
+	(*ret) = (ParseTrace) {
+		.scheme = scheme,
+		.events = events,
+		.capacity = roundedCapacity,
+		.numRecorded = 0,
+		.startTime = getTime(),
+		.threadId = (uint32_t) atomic_fetch_add(&nextThreadId, 1)
+	};
+
+	return ret;
+}
+
+void ParseTrace_Free(ParseTrace* trace) {
+	if(trace == NULL) {
+		return;
+	}
+
+	free(trace->events);
+	free(trace);
+}
+
+void ParseTrace_Clear(ParseTrace* trace) {
+	trace->numRecorded = 0;
+	trace->startTime = getTime();
+}
+
+void ParseTrace_Record(ParseTrace* trace, ParseRule* rule, bool isExit, size_t offset, size_t length, bool success) {
+	if(rule->scheme != trace->scheme) {
+		return;
+	}
+
+	trace->events[trace->numRecorded & (trace->capacity - 1)] = (ParseTraceEvent) {
+		.timestamp = getTime() - trace->startTime,
+		.offset = offset,
+		.length = length,
+		.ruleIndex = Rule_GetIndex(rule),
+		.isExit = isExit,
+		.success = success
+	};
+	trace->numRecorded++;
+}
+
+static void writeJsonString(const char* str, size_t len, FILE* fout) {
+	fputc('"', fout);
+	for(size_t i = 0; i < len; i++) {
+		unsigned char c = (unsigned char) str[i];
+		if((c == '"') || (c == '\\')) {
+			fprintf(fout, "\\%c", c);
+		} else if((c < 0x20) || (c >= 0x7F)) {
+			fprintf(fout, "\\u%04x", c);
+		} else {
+			fputc(c, fout);
+		}
+	}
+	fputc('"', fout);
+}
+
+// The name of every rule in the scheme, as Rule_Print prints it. Rules that can't be named are NULL.
+static char** getRuleNames(ParseScheme* scheme, size_t** lengths_ret) {
+	char** names = (char**) calloc(scheme->numRules, sizeof(char*));
+	size_t* lengths = (size_t*) calloc(scheme->numRules, sizeof(size_t));
+
+	if((names == NULL) || (lengths == NULL)) {
+		free(names);
+		free(lengths);
+		return NULL;
+	}
+
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		FILE* nameFile = open_memstream(&names[i], &lengths[i]);
+		if(nameFile == NULL) {
+			continue;
+		}
+
+		Rule_Print(scheme->rules + i, nameFile);
+		fclose(nameFile);
+
+		// Some rules end their description with a newline.
+		while((lengths[i] > 0) && (names[i][lengths[i] - 1] == '\n')) {
+			lengths[i]--;
+		}
+	}
+
+	(*lengths_ret) = lengths;
+	return names;
+}
+
+static void freeRuleNames(ParseScheme* scheme, char** names, size_t* lengths) {
+	for(size_t i = 0; i < scheme->numRules; i++) {
+		free(names[i]);
+	}
+	free(names);
+	free(lengths);
+}
+
+static bool writeTraceEvents(ParseTrace* trace, uint64_t startTime, bool* first, FILE* fout) {
+	size_t* nameLengths;
+	char** names = getRuleNames(trace->scheme, &nameLengths);
+
+	if(names == NULL) {
+		fprintf(stderr, "Error: unable to allocate rule names for the trace!\n");
+		return false;
+	}
+
+	size_t oldest = (trace->numRecorded > trace->capacity)? trace->numRecorded - trace->capacity : 0;
+
+	// How many of the enters that are still in the buffer haven't exited yet.
+	size_t depth = 0;
+
+	for(size_t i = oldest; i < trace->numRecorded; i++) {
+		ParseTraceEvent* event = &trace->events[i & (trace->capacity - 1)];
+
+		if(event->isExit) {
+			if(depth == 0) {
+				continue;
+			}
+			depth--;
+		} else {
+			depth++;
+		}
+
+		// Chrome traces count in microseconds.
+		uint64_t timestamp = trace->startTime - startTime + event->timestamp;
+
+		fprintf(fout, "%s\n{\"name\":", (*first)? "" : ",");
+		(*first) = false;
+
+		if((event->ruleIndex < trace->scheme->numRules) && (names[event->ruleIndex] != NULL)) {
+			writeJsonString(names[event->ruleIndex], nameLengths[event->ruleIndex], fout);
+		} else {
+			fprintf(fout, "\"0x%X\"", event->ruleIndex);
+		}
+
+		fprintf(fout, ",\"cat\":\"rule\",\"ph\":\"%c\",\"ts\":%lu.%03lu,\"pid\":1,\"tid\":%u,",
+			event->isExit? 'E' : 'B', timestamp / 1000, timestamp % 1000, trace->threadId);
+
+		if(event->isExit) {
+			fprintf(fout, "\"args\":{\"offset\":%lu,\"success\":%s,\"length\":%lu}}",
+				event->offset, event->success? "true" : "false", event->length);
+		} else {
+			fprintf(fout, "\"args\":{\"offset\":%lu}}", event->offset);
+		}
+	}
+
+	freeRuleNames(trace->scheme, names, nameLengths);
+	return true;
+}
+
+bool ParseTrace_WriteChromeJson(ParseTrace** traces, size_t numTraces, FILE* fout) {
+	if((traces == NULL) || (fout == NULL)) {
+		fprintf(stderr, "Error: attempting to write null traces or to a null file.\n");
+		return false;
+	}
+
+	// Every trace is shown relative to the earliest one, so that they line up.
+	uint64_t startTime = UINT64_MAX;
+	for(size_t i = 0; i < numTraces; i++) {
+		if((traces[i] != NULL) && (traces[i]->startTime < startTime)) {
+			startTime = traces[i]->startTime;
+		}
+	}
+
+	bool first = true;
+
+	fprintf(fout, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+	for(size_t i = 0; i < numTraces; i++) {
+		if((traces[i] != NULL) && !writeTraceEvents(traces[i], startTime, &first, fout)) {
+			return false;
+		}
+	}
+
+	fprintf(fout, "\n]}\n");
+
+	return !ferror(fout);
+}
@@ -0,0 +1,365 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+#include "ParseTree.h"
+
+const size_t PARSE_TREE_NODES_BUFFER_LENGTH = 256;
+
+static const char PARSE_TREE_MAGIC[4] = { 'E', 'K', 'W', 'T' };
+static const uint8_t PARSE_TREE_VERSION = 1;
+
+// A 64 bit value takes up at most 10 bytes as a varint.
+#define PARSE_TREE_MAX_VARINT_LENGTH 10
+
+ParseTree* ParseTree_Create(ParseScheme* scheme) {
+	if(scheme == NULL) {
+		fprintf(stderr, "Error: attempting to create a tree for a null scheme.\n");
+		return NULL;
+	}
+
+	ParseTree* ret = (ParseTree*) malloc(sizeof(ParseTree));
+	ParseEvents* events = ParseEvents_Create(scheme);
+	ParseTreeNode* nodes = (ParseTreeNode*) malloc(sizeof(ParseTreeNode) * PARSE_TREE_NODES_BUFFER_LENGTH);
+
+	if((ret == NULL) || (events == NULL) || (nodes == NULL)) {
+		fprintf(stderr, "Error: unable to allocate parse tree!\n");
+		free(ret);
+		ParseEvents_Free(events);
+		free(nodes);
+		return NULL;
+	}
+
+	(*ret) = (ParseTree) {
+		.scheme = scheme,
+		.events = events,
+		.nodes = nodes,
+		.numNodes = 0,
+		.maxNodes = PARSE_TREE_NODES_BUFFER_LENGTH,
+		.current = SIZE_MAX,
+		.inputLen = 0,
+		.errorState = 0
+	};
+
+	return ret;
+}
+
+void ParseTree_Free(ParseTree* tree) {
+	if(tree == NULL) {
+		return;
+	}
+
+	ParseEvents_Free(tree->events);
+	free(tree->nodes);
+	free(tree);
+}
+
+static bool onTreeEvent(ParseRule* rule, ParseEventType type, size_t offset, size_t length, void* userData) {
+	ParseTree* tree = (ParseTree*) userData;
+
+	if(type == PARSE_EVENT_EXIT) {
+		tree->nodes[tree->current].length = length;
+		tree->current = tree->nodes[tree->current].parent;
+		return true;
+	}
+
+	if(tree->numNodes == tree->maxNodes) {
+		size_t newLength = tree->maxNodes * 2;
+		ParseTreeNode* newNodes = (ParseTreeNode*) realloc(tree->nodes, sizeof(ParseTreeNode) * newLength);
+
+		if(newNodes == NULL) {
+			fprintf(stderr, "Error: unable to allocate space for parse tree nodes!\n");
+			tree->errorState = 2;
+			return false;
+		}
+
+		tree->nodes = newNodes;
+		tree->maxNodes = newLength;
+	}
+
+	if(tree->current != SIZE_MAX) {
+		tree->nodes[tree->current].numChildren++;
+	}
+
+	tree->nodes[tree->numNodes] = (ParseTreeNode) {
+		.ruleIndex = Rule_GetIndex(rule),
+		.parent = tree->current,
+		.offset = offset,
+		.length = 0,
+		.numChildren = 0
+	};
+	tree->current = tree->numNodes++;
+
+	return true;
+}
+
+bool ParseTree_Select(ParseTree* tree, ParseRule* rule) {
+	if(tree == NULL) {
+		fprintf(stderr, "Error: attempting to select a rule for a null tree.\n");
+		return false;
+	}
+
+	return ParseEvents_Select(tree->events, rule, onTreeEvent, tree);
+}
+
+ParseResult ParseTree_Parse(ParseTree* tree, ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if((tree == NULL) || (ctx == NULL)) {
+		fprintf(stderr, "Error: attempting to parse into a null tree or with a null context.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	tree->numNodes = 0;
+	tree->current = SIZE_MAX;
+	tree->inputLen = ctx->inputLen;
+	tree->events->numPending = 0;
+	tree->events->numUnsafeOpen = 0;
+
+	if(!ParseTree_Select(tree, rule)) {
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	ParseEvents* outerEvents = ctx->events;
+	ctx->events = tree->events;
+
+	ParseResult result = Rule_ParseWithContext(rule, ctx, str, result_ret);
+
+	ctx->events = outerEvents;
+
+	// Events passed on before a failure are only partial.
+	if(!result.success) {
+		tree->numNodes = 0;
+		tree->current = SIZE_MAX;
+	}
+
+	return result;
+}
+
+static size_t encodeVarint(uint8_t* buf, uint64_t value) {
+	size_t len = 0;
+
+	while(value >= 0x80) {
+		buf[len++] = (uint8_t) (value | 0x80);
+		value >>= 7;
+	}
+	buf[len++] = (uint8_t) value;
+
+	return len;
+}
+
+static size_t encodeNode(ParseTree* tree, size_t i, size_t descendantBytes, uint8_t* buf) {
+	ParseTreeNode* node = &tree->nodes[i];
+	size_t parentOffset = (node->parent == SIZE_MAX)? 0 : tree->nodes[node->parent].offset;
+	size_t len = 0;
+
+	len += encodeVarint(buf + len, node->ruleIndex);
+	len += encodeVarint(buf + len, node->offset - parentOffset);
+	len += encodeVarint(buf + len, node->length);
+	len += encodeVarint(buf + len, node->numChildren);
+	len += encodeVarint(buf + len, descendantBytes);
+
+	return len;
+}
+
+bool ParseTree_Write(ParseTree* tree, FILE* fout) {
+	if((tree == NULL) || (fout == NULL)) {
+		fprintf(stderr, "Error: attempting to write a null tree or to a null file.\n");
+		return false;
+	}
+
+	// Children come after their parent in preorder, so going backwards sizes every subtree before the node
+	// that needs it.
+	size_t* descendantBytes = (size_t*) calloc(tree->numNodes + 1, sizeof(size_t));
+
+	if(descendantBytes == NULL) {
+		fprintf(stderr, "Error: unable to allocate space to write parse tree!\n");
+		tree->errorState = 2;
+		return false;
+	}
+
+	uint8_t buf[5 * PARSE_TREE_MAX_VARINT_LENGTH];
+
+	for(size_t i = tree->numNodes; i-- > 0;) {
+		size_t parent = tree->nodes[i].parent;
+		if(parent != SIZE_MAX) {
+			descendantBytes[parent] += encodeNode(tree, i, descendantBytes[i], buf) + descendantBytes[i];
+		}
+	}
+
+	bool ok = (fwrite(PARSE_TREE_MAGIC, 1, sizeof(PARSE_TREE_MAGIC), fout) == sizeof(PARSE_TREE_MAGIC));
+	ok = ok && (fputc(PARSE_TREE_VERSION, fout) != EOF);
+
+	size_t len = 0;
+	len += encodeVarint(buf + len, tree->events->numRules);
+	len += encodeVarint(buf + len, tree->inputLen);
+	len += encodeVarint(buf + len, tree->numNodes);
+	ok = ok && (fwrite(buf, 1, len, fout) == len);
+
+	for(size_t i = 0; ok && (i < tree->numNodes); i++) {
+		len = encodeNode(tree, i, descendantBytes[i], buf);
+		ok = (fwrite(buf, 1, len, fout) == len);
+	}
+
+	free(descendantBytes);
+
+	if(!ok) {
+		fprintf(stderr, "Error: unable to write parse tree.\n");
+	}
+
+	return ok;
+}
+
+// Reads a varint at *pos, which is moved past it. Returns false if it runs past the end of the file.
+static bool decodeVarint(ParseTreeFile* file, size_t* pos, uint64_t* value_ret) {
+	uint64_t value = 0;
+
+	for(unsigned shift = 0; (shift < 64) && (*pos < file->size); shift += 7) {
+		uint8_t byte = file->data[(*pos)++];
+		value |= (uint64_t) (byte & 0x7F) << shift;
+
+		if((byte & 0x80) == 0) {
+			(*value_ret) = value;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+ParseTreeFile* ParseTreeFile_Open(const char* path) {
+	if(path == NULL) {
+		fprintf(stderr, "Error: attempting to open a tree from a null path.\n");
+		return NULL;
+	}
+
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0) {
+		fprintf(stderr, "Error: unable to open parse tree file %s.\n", path);
+		return NULL;
+	}
+
+	struct stat st;
+	if((fstat(fd, &st) != 0) || ((size_t) st.st_size < sizeof(PARSE_TREE_MAGIC) + 1)) {
+		fprintf(stderr, "Error: %s is not a parse tree file.\n", path);
+		close(fd);
+		return NULL;
+	}
+
+	// The mapping stays valid after the file is closed.
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(data == MAP_FAILED) {
+		fprintf(stderr, "Error: unable to map parse tree file %s.\n", path);
+		return NULL;
+	}
+
+	ParseTreeFile* ret = (ParseTreeFile*) malloc(sizeof(ParseTreeFile));
+
+	if(ret == NULL) {
+		fprintf(stderr, "Error: unable to allocate parse tree file!\n");
+		munmap(data, st.st_size);
+		return NULL;
+	}
+
+	(*ret) = (ParseTreeFile) {
+		.data = (uint8_t*) data,
+		.size = st.st_size
+	};
+
+	size_t pos = sizeof(PARSE_TREE_MAGIC) + 1;
+	uint64_t numRules, inputLen, numNodes;
+
+	if((memcmp(ret->data, PARSE_TREE_MAGIC, sizeof(PARSE_TREE_MAGIC)) != 0) ||
+		(ret->data[sizeof(PARSE_TREE_MAGIC)] != PARSE_TREE_VERSION) ||
+		!decodeVarint(ret, &pos, &numRules) || !decodeVarint(ret, &pos, &inputLen) || !decodeVarint(ret, &pos, &numNodes)) {
+		fprintf(stderr, "Error: %s is not a parse tree file.\n", path);
+		ParseTreeFile_Close(ret);
+		return NULL;
+	}
+
+	ret->nodesStart = pos;
+	ret->numRules = numRules;
+	ret->inputLen = inputLen;
+	ret->numNodes = numNodes;
+
+	return ret;
+}
+
+void ParseTreeFile_Close(ParseTreeFile* file) {
+	if(file == NULL) {
+		return;
+	}
+
+	munmap(file->data, file->size);
+	free(file);
+}
+
+static bool readNode(ParseTreeFile* file, size_t pos, size_t parentOffset, size_t siblingsLeft, ParseTreeCursor* cursor_ret) {
+	uint64_t ruleIndex, relativeOffset, length, numChildren, descendantBytes;
+
+	if(!decodeVarint(file, &pos, &ruleIndex) || !decodeVarint(file, &pos, &relativeOffset) ||
+		!decodeVarint(file, &pos, &length) || !decodeVarint(file, &pos, &numChildren) ||
+		!decodeVarint(file, &pos, &descendantBytes) || (descendantBytes > file->size - pos) ||
+		(ruleIndex >= file->numRules)) {
+		return false;
+	}
+
+	(*cursor_ret) = (ParseTreeCursor) {
+		.file = file,
+		.ruleIndex = ruleIndex,
+		.offset = parentOffset + relativeOffset,
+		.length = length,
+		.numChildren = numChildren,
+		.childrenStart = pos,
+		.nextStart = pos + descendantBytes,
+		.parentOffset = parentOffset,
+		.siblingsLeft = siblingsLeft
+	};
+
+	return true;
+}
+
+bool ParseTreeFile_GetRoot(ParseTreeFile* file, ParseTreeCursor* cursor_ret) {
+	if((file == NULL) || (cursor_ret == NULL)) {
+		fprintf(stderr, "Error: attempting to get the root of a null tree file, or into a null cursor.\n");
+		return false;
+	}
+
+	if(file->numNodes == 0) {
+		return false;
+	}
+
+	return readNode(file, file->nodesStart, 0, 0, cursor_ret);
+}
+
+bool ParseTreeCursor_FirstChild(ParseTreeCursor* cursor, ParseTreeCursor* child_ret) {
+	if((cursor == NULL) || (child_ret == NULL)) {
+		fprintf(stderr, "Error: attempting to move a null cursor.\n");
+		return false;
+	}
+
+	if(cursor->numChildren == 0) {
+		return false;
+	}
+
+	return readNode(cursor->file, cursor->childrenStart, cursor->offset, cursor->numChildren - 1, child_ret);
+}
+
+bool ParseTreeCursor_NextSibling(ParseTreeCursor* cursor, ParseTreeCursor* sibling_ret) {
+	if((cursor == NULL) || (sibling_ret == NULL)) {
+		fprintf(stderr, "Error: attempting to move a null cursor.\n");
+		return false;
+	}
+
+	if(cursor->siblingsLeft == 0) {
+		return false;
+	}
+
+	return readNode(cursor->file, cursor->nextStart, cursor->parentOffset, cursor->siblingsLeft - 1, sibling_ret);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "ParseFramework.h"
 
 
@@ -8,73 +9,76 @@ ParseRule* RepeatRule_CreateWithBounds(ParseScheme* scheme, size_t minReps, size
 		return NULL;
 	}
 
-	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
-
-	if(ret == NULL) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to create a repeat rule around a null rule!\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
 		return NULL;
 	}
 
-	ret->repeatRule = (RepeatParseRule*) malloc(sizeof(RepeatParseRule));
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
 
-	if(ret->repeatRule == NULL) {
-		fprintf(stderr, "Error: unable to allocate repeat rule!\n");
-		ParseScheme_Free(scheme);
-		scheme->errorState = 2;
+	if(ret == NULL) {
 		return NULL;
 	}
 
-	ret->repeatRule->rule = rule;
-	ret->repeatRule->minReps = minReps;
-	ret->repeatRule->maxReps = maxReps;
+	ret->repeatRule = (RepeatParseRule) {
+		.rule = Rule_GetIndex(rule),
+		.minReps = minReps,
+		.maxReps = maxReps
+	};
 
 	ret->ruleType = PARSE_RULE_REPEAT;
 
-	return ret;
+	return ParseScheme_InternRule(scheme, ret);
 }
 
 ParseRule* RepeatRule_Create(ParseScheme* scheme, bool required, ParseRule* rule) {
 	return RepeatRule_CreateWithBounds(scheme, required? 1 : 0, SIZE_MAX, rule);
 }
 
-void RepeatRule_Free(RepeatParseRule* rule) {
-	free(rule);
-}
-
-ParseResult RepeatRule_Parse(RepeatParseRule* rule, char* str, ParseResult* result_ret) {
+ParseResult RepeatRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	if(rule == NULL) {
 		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
+	RepeatParseRule* data = &rule->repeatRule;
+	ParseRule* innerRule = Rule_GetInnerRule(rule);
 	size_t strIndex = 0;
 	size_t numReps = 0;
+	bool cut = false;
 
-	for(; numReps <= rule->maxReps; numReps++) {
+	for(; numReps < data->maxReps; numReps++) {
 		ParseResult res;
-		if(Rule_Parse(rule->rule, str + strIndex, &res).success) {
+		if(Rule_ParseWithContext(innerRule, ctx, str + strIndex, &res).success) {
 			strIndex += res.length;
+			cut = cut || res.cut;
+		} else if(res.cut) {
+			// The repetition committed before failing, so we can't backtrack to the end of the previous one.
+			return setParseResultWithCut(result_ret, false, NULL, 0, true);
 		} else {
 			break;
 		}
 	}
 
-	if(numReps < rule->minReps) {
-		return setParseResult(result_ret, false, NULL, 0);
+	if(numReps < data->minReps) {
+		return setParseResultWithCut(result_ret, false, NULL, 0, cut);
 	}
 
-	return setParseResult(result_ret, true, str, strIndex);
+	return setParseResultWithCut(result_ret, true, str, strIndex, cut);
 }
 
-void RepeatRule_PrintDeep(RepeatParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+void RepeatRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
 	fprintf(fout, "Repeat(");
-	Rule_PrintSimpleRulePointer(rule->rule, fout);
+	Rule_PrintSimpleRulePointer(Rule_GetInnerRule(rule), fout);
 	fprintf(fout, ")");
 
 	if(depth < maxDepth) {
-		Rule_PrintDeep(rule->rule, fout, depth + 1, maxDepth, indentStr);
+		Rule_PrintDeep(Rule_GetInnerRule(rule), fout, depth + 1, maxDepth, indentStr);
 	}
 }
 
-void RepeatRule_Print(RepeatParseRule* rule, FILE* fout) {
+void RepeatRule_Print(ParseRule* rule, FILE* fout) {
 	RepeatRule_PrintDeep(rule, fout, 0, 0, "");
 }
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "RuleAnalysis.h"
+
+void ByteSet_Clear(ByteSet* set) {
+	memset(set->bits, 0, sizeof(set->bits));
+}
+
+void ByteSet_Fill(ByteSet* set) {
+	memset(set->bits, 0xFF, sizeof(set->bits));
+}
+
+void ByteSet_Add(ByteSet* set, unsigned char c) {
+	set->bits[c >> 6] |= ((uint64_t) 1) << (c & 63);
+}
+
+void ByteSet_AddBothCases(ByteSet* set, unsigned char c) {
+	ByteSet_Add(set, c);
+	if((c >= 'a') && (c <= 'z')) {
+		ByteSet_Add(set, c - ('a' - 'A'));
+	} else if((c >= 'A') && (c <= 'Z')) {
+		ByteSet_Add(set, c + ('a' - 'A'));
+	}
+}
+
+bool ByteSet_Contains(const ByteSet* set, unsigned char c) {
+	return (set->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+void ByteSet_Union(ByteSet* set, const ByteSet* other) {
+	for(size_t i = 0; i < 4; i++) {
+		set->bits[i] |= other->bits[i];
+	}
+}
+
+bool ByteSet_Intersects(const ByteSet* a, const ByteSet* b) {
+	for(size_t i = 0; i < 4; i++) {
+		if(a->bits[i] & b->bits[i]) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t ByteSet_Count(const ByteSet* set) {
+	size_t count = 0;
+	for(size_t i = 0; i < 4; i++) {
+		count += __builtin_popcountll(set->bits[i]);
+	}
+	return count;
+}
+
+
+// The rules that are currently being analyzed, so that recursion through forward rules terminates.
+typedef struct AnalysisFrame_s {
+	ParseRule* rule;
+	struct AnalysisFrame_s* parent;
+
+	// If not NULL, set once a rule of an unknown type had to be assumed to match anything.
+	bool* guessed;
+} AnalysisFrame;
+
+// Comments count as starting with the first byte of their delimiter.
+static void getSkipperFirstSet(ParseScheme* scheme, ByteSet* first_ret) {
+	ByteSet_Clear(first_ret);
+
+	for(size_t i = 0; i < scheme->numSkipBytes; i++) {
+		ByteSet_Add(first_ret, scheme->skipBytes[i]);
+	}
+	if(scheme->skipLineComment != UINT32_MAX) {
+		ByteSet_Add(first_ret, scheme->stringPool[scheme->skipLineComment]);
+	}
+	if(scheme->skipBlockCommentStart != UINT32_MAX) {
+		ByteSet_Add(first_ret, scheme->stringPool[scheme->skipBlockCommentStart]);
+	}
+}
+
+static bool getFirstSet(ParseRule* rule, ByteSet* first_ret, AnalysisFrame* parent) {
+	ByteSet_Clear(first_ret);
+
+	if(rule == NULL) {
+		return false;
+	}
+
+	for(AnalysisFrame* frame = parent; frame != NULL; frame = frame->parent) {
+		if(frame->rule == rule) {
+			// Left recursion. A PEG never gets out of it, so it contributes nothing.
+			return false;
+		}
+	}
+
+	AnalysisFrame frame = { .rule = rule, .parent = parent, .guessed = (parent != NULL)? parent->guessed : NULL };
+	ByteSet childFirst;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			for(size_t i = 0; i < rule->alphabetRule.alphabetLen; i++) {
+				if(rule->alphabetRule.caseInsensitive) {
+					ByteSet_AddBothCases(first_ret, Rule_GetText(rule)[i]);
+				} else {
+					ByteSet_Add(first_ret, Rule_GetText(rule)[i]);
+				}
+			}
+			return false;
+		case PARSE_RULE_STRING:
+			if(rule->stringRule.stringLen == 0) {
+				return true;
+			}
+			if(rule->stringRule.caseInsensitive) {
+				ByteSet_AddBothCases(first_ret, Rule_GetText(rule)[0]);
+			} else {
+				ByteSet_Add(first_ret, Rule_GetText(rule)[0]);
+			}
+			return false;
+		case PARSE_RULE_SEQUENCE:
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				if(rule->sequenceRule.skip) {
+					getSkipperFirstSet(rule->scheme, &childFirst);
+					ByteSet_Union(first_ret, &childFirst);
+				}
+				bool nullable = getFirstSet(Rule_GetListRule(rule, i), &childFirst, &frame);
+				ByteSet_Union(first_ret, &childFirst);
+				if(!nullable) {
+					return false;
+				}
+			}
+			return true;
+		case PARSE_RULE_OPTION_LIST: {
+			bool nullable = false;
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				nullable |= getFirstSet(Rule_GetListRule(rule, i), &childFirst, &frame);
+				ByteSet_Union(first_ret, &childFirst);
+			}
+			return nullable;
+		}
+		case PARSE_RULE_OPTIONAL:
+			getFirstSet(Rule_GetInnerRule(rule), first_ret, &frame);
+			return true;
+		case PARSE_RULE_REPEAT: {
+			if(rule->repeatRule.maxReps == 0) {
+				return true;
+			}
+			bool nullable = getFirstSet(Rule_GetInnerRule(rule), first_ret, &frame);
+			return nullable || (rule->repeatRule.minReps == 0);
+		}
+		case PARSE_RULE_CUT:
+			return true;
+		case PARSE_RULE_TOKEN:
+			// Tokens can have any amount of skipped input in front of them.
+			ByteSet_Fill(first_ret);
+			return false;
+		case PARSE_RULE_SKIP:
+			getSkipperFirstSet(rule->scheme, first_ret);
+			return true;
+		case PARSE_RULE_LAZY:
+			if(rule->lazyRule.skipRule != UINT32_MAX) {
+				return getFirstSet(rule->scheme->rules + rule->lazyRule.skipRule, first_ret, &frame);
+			}
+			ByteSet_Add(first_ret, rule->lazyRule.open);
+			return false;
+		case PARSE_RULE_OPERATOR_PRECEDENCE: {
+			// Operators that match nothing are ignored, so the expression can only be empty if the operand can.
+			bool nullable = getFirstSet(Rule_GetOperandRule(rule), first_ret, &frame);
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				if(nullable || (Rule_GetOperatorKind(rule, i) == PARSE_OPERATOR_PREFIX)) {
+					ByteSet childFirst;
+					getFirstSet(Rule_GetOperatorRule(rule, i), &childFirst, &frame);
+					ByteSet_Union(first_ret, &childFirst);
+				}
+			}
+			return nullable;
+		}
+		case PARSE_RULE_SCAN_UNTIL: {
+			// The escape byte isn't a stop byte, so it can start a match too.
+			const char* stops = rule->scheme->stringPool + rule->scanUntilRule.stops;
+			ByteSet stopSet;
+			ByteSet_Clear(&stopSet);
+			for(size_t i = 0; i < rule->scanUntilRule.numStops; i++) {
+				ByteSet_Add(&stopSet, stops[i]);
+			}
+			for(int c = 0; c < 256; c++) {
+				if(!ByteSet_Contains(&stopSet, c)) {
+					ByteSet_Add(first_ret, c);
+				}
+			}
+			return !rule->scanUntilRule.required;
+		}
+		case PARSE_RULE_SEPARATED_LIST: {
+			if(rule->separatedListRule.maxItems == 0) {
+				return true;
+			}
+			// Only a separator after an empty item can start the match.
+			bool nullable = getFirstSet(Rule_GetItemRule(rule), first_ret, &frame);
+			if(nullable && ((rule->separatedListRule.maxItems > 1) || rule->separatedListRule.allowTrailing)) {
+				ByteSet separatorFirst;
+				getFirstSet(Rule_GetSeparatorRule(rule), &separatorFirst, &frame);
+				ByteSet_Union(first_ret, &separatorFirst);
+			}
+			return nullable || (rule->separatedListRule.minItems == 0);
+		}
+		default: {
+			const ParseRuleVTable* vtable = ParseRuleType_GetVTable(rule->ruleType);
+			if((vtable != NULL) && (vtable->getFirstSet != NULL)) {
+				return vtable->getFirstSet(rule, first_ret);
+			}
+
+			// We don't know anything about this rule, so assume that it could match anything.
+			if(frame.guessed != NULL) {
+				(*frame.guessed) = true;
+			}
+			ByteSet_Fill(first_ret);
+			return true;
+		}
+	}
+}
+
+bool Rule_GetFirstSet(ParseRule* rule, ByteSet* first_ret) {
+	return getFirstSet(rule, first_ret, NULL);
+}
+
+bool Rule_GetFirstSetIfKnown(ParseRule* rule, ByteSet* first_ret, bool* known_ret) {
+	bool guessed = false;
+	AnalysisFrame root = { .rule = NULL, .parent = NULL, .guessed = &guessed };
+	bool nullable = getFirstSet(rule, first_ret, &root);
+
+	(*known_ret) = !guessed;
+	return nullable;
+}
+
+// complete_ret is set if every match of the rule is exactly the returned prefix.
+static size_t getLiteralPrefix(ParseRule* rule, char* prefix_ret, size_t maxLen, bool* complete_ret, AnalysisFrame* parent) {
+	(*complete_ret) = false;
+
+	if(rule == NULL) {
+		return 0;
+	}
+
+	for(AnalysisFrame* frame = parent; frame != NULL; frame = frame->parent) {
+		if(frame->rule == rule) {
+			return 0;
+		}
+	}
+
+	AnalysisFrame frame = { .rule = rule, .parent = parent, .guessed = (parent != NULL)? parent->guessed : NULL };
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_STRING: {
+			if(rule->stringRule.caseInsensitive) {
+				return 0;
+			}
+			size_t len = (rule->stringRule.stringLen < maxLen)? rule->stringRule.stringLen : maxLen;
+			memcpy(prefix_ret, Rule_GetText(rule), len);
+			(*complete_ret) = (len == rule->stringRule.stringLen);
+			return len;
+		}
+		case PARSE_RULE_ALPHABET:
+			if(rule->alphabetRule.caseInsensitive || (rule->alphabetRule.alphabetLen != 1) || (maxLen == 0)) {
+				return 0;
+			}
+			prefix_ret[0] = Rule_GetText(rule)[0];
+			(*complete_ret) = true;
+			return 1;
+		case PARSE_RULE_SEQUENCE: {
+			// Skipped text can come before any element.
+			if(rule->sequenceRule.skip) {
+				return 0;
+			}
+			size_t len = 0;
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				bool complete;
+				len += getLiteralPrefix(Rule_GetListRule(rule, i), prefix_ret + len, maxLen - len, &complete, &frame);
+				if(!complete) {
+					return len;
+				}
+			}
+			(*complete_ret) = true;
+			return len;
+		}
+		case PARSE_RULE_CUT:
+			(*complete_ret) = true;
+			return 0;
+		case PARSE_RULE_LAZY:
+			if((rule->lazyRule.skipRule != UINT32_MAX) || (maxLen == 0)) {
+				return 0;
+			}
+			prefix_ret[0] = rule->lazyRule.open;
+			return 1;
+		case PARSE_RULE_SEPARATED_LIST: {
+			if(rule->separatedListRule.minItems == 0) {
+				return 0;
+			}
+			// The prefix can't run on into the separator, since there might be only the one item.
+			bool complete;
+			return getLiteralPrefix(Rule_GetItemRule(rule), prefix_ret, maxLen, &complete, &frame);
+		}
+		default:
+			return 0;
+	}
+}
+
+size_t Rule_GetLiteralPrefix(ParseRule* rule, char* prefix_ret, size_t maxLen) {
+	bool complete;
+	return getLiteralPrefix(rule, prefix_ret, maxLen, &complete, NULL);
+}
+
+static bool canCutBeforeInput(ParseRule* rule, AnalysisFrame* parent) {
+	if(rule == NULL) {
+		return false;
+	}
+
+	for(AnalysisFrame* frame = parent; frame != NULL; frame = frame->parent) {
+		if(frame->rule == rule) {
+			return false;
+		}
+	}
+
+	AnalysisFrame frame = { .rule = rule, .parent = parent, .guessed = (parent != NULL)? parent->guessed : NULL };
+	ByteSet first;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_CUT:
+			return true;
+		case PARSE_RULE_ALPHABET:
+		case PARSE_RULE_STRING:
+		case PARSE_RULE_TOKEN:
+		case PARSE_RULE_SKIP:
+		case PARSE_RULE_SCAN_UNTIL:
+			return false;
+		case PARSE_RULE_SEQUENCE:
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				ParseRule* element = Rule_GetListRule(rule, i);
+				if(canCutBeforeInput(element, &frame)) {
+					return true;
+				}
+				// Anything after this element only runs once some input has been matched.
+				if(!getFirstSet(element, &first, &frame)) {
+					return false;
+				}
+			}
+			return false;
+		case PARSE_RULE_OPTION_LIST:
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				if(canCutBeforeInput(Rule_GetListRule(rule, i), &frame)) {
+					return true;
+				}
+			}
+			return false;
+		case PARSE_RULE_OPTIONAL:
+		case PARSE_RULE_REPEAT:
+			return canCutBeforeInput(Rule_GetInnerRule(rule), &frame);
+		case PARSE_RULE_LAZY:
+			// The inner rule isn't parsed until the region is expanded.
+			return (rule->lazyRule.skipRule != UINT32_MAX) && canCutBeforeInput(rule->scheme->rules + rule->lazyRule.skipRule, &frame);
+		case PARSE_RULE_OPERATOR_PRECEDENCE: {
+			bool nullable = getFirstSet(Rule_GetOperandRule(rule), &first, &frame);
+			if(canCutBeforeInput(Rule_GetOperandRule(rule), &frame)) {
+				return true;
+			}
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				if((nullable || (Rule_GetOperatorKind(rule, i) == PARSE_OPERATOR_PREFIX)) && canCutBeforeInput(Rule_GetOperatorRule(rule, i), &frame)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case PARSE_RULE_SEPARATED_LIST:
+			if(canCutBeforeInput(Rule_GetItemRule(rule), &frame)) {
+				return true;
+			}
+			return getFirstSet(Rule_GetItemRule(rule), &first, &frame) && canCutBeforeInput(Rule_GetSeparatorRule(rule), &frame);
+		default:
+			// We don't know what this rule does, so assume the worst.
+			return true;
+	}
+}
+
+bool Rule_CanCutBeforeInput(ParseRule* rule) {
+	return canCutBeforeInput(rule, NULL);
+}
+
+bool Rule_AreMutuallyExclusive(ParseRule* a, ParseRule* b) {
+	ByteSet firstA, firstB;
+
+	if(Rule_GetFirstSet(a, &firstA) || Rule_GetFirstSet(b, &firstB)) {
+		return false;
+	}
+
+	if(ByteSet_Intersects(&firstA, &firstB)) {
+		return false;
+	}
+
+	return !Rule_CanCutBeforeInput(a) && !Rule_CanCutBeforeInput(b);
+}
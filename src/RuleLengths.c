@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "ParseFramework.h"
+#include "RuleLengths.h"
+
+static size_t addLengths(size_t a, size_t b) {
+	return (a > SIZE_MAX - b)? SIZE_MAX : a + b;
+}
+
+static size_t multiplyLength(size_t length, size_t times) {
+	if((length == 0) || (times == 0)) {
+		return 0;
+	}
+	return (length > SIZE_MAX / times)? SIZE_MAX : length * times;
+}
+
+static ParseRuleLengths getRuleLengths(ParseRule* rule, const ParseRuleLengths* lengths) {
+	ParseScheme* scheme = rule->scheme;
+
+	switch(rule->ruleType) {
+		case PARSE_RULE_ALPHABET:
+			return (ParseRuleLengths) { .minLength = 1, .maxLength = 1, .canCut = false };
+		case PARSE_RULE_STRING:
+			return (ParseRuleLengths) {
+				.minLength = rule->stringRule.stringLen,
+				.maxLength = rule->stringRule.stringLen,
+				.canCut = false
+			};
+		case PARSE_RULE_SEQUENCE: {
+			ParseRuleLengths ret = { .minLength = 0, .maxLength = 0, .canCut = false };
+			for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+				const ParseRuleLengths* element = lengths + scheme->childIndices[rule->sequenceRule.firstRule + i];
+				ret.minLength = addLengths(ret.minLength, element->minLength);
+				ret.maxLength = addLengths(ret.maxLength, element->maxLength);
+				ret.canCut = ret.canCut || element->canCut;
+			}
+			// There is no limit to how much the skipper can skip.
+			if(rule->sequenceRule.skip) {
+				ret.maxLength = SIZE_MAX;
+			}
+			return ret;
+		}
+		case PARSE_RULE_OPTION_LIST: {
+			ParseRuleLengths ret = { .minLength = SIZE_MAX, .maxLength = 0, .canCut = false };
+			for(size_t i = 0; i < rule->optionListRule.rulesLen; i++) {
+				const ParseRuleLengths* option = lengths + scheme->childIndices[rule->optionListRule.firstRule + i];
+				ret.minLength = (option->minLength < ret.minLength)? option->minLength : ret.minLength;
+				ret.maxLength = (option->maxLength > ret.maxLength)? option->maxLength : ret.maxLength;
+				ret.canCut = ret.canCut || option->canCut;
+			}
+			if(ret.minLength == SIZE_MAX) {
+				ret.minLength = 0;
+			}
+			return ret;
+		}
+		case PARSE_RULE_OPTIONAL: {
+			ParseRuleLengths ret = lengths[rule->optionalRule.rule];
+			ret.minLength = 0;
+			return ret;
+		}
+		case PARSE_RULE_REPEAT: {
+			const ParseRuleLengths* inner = lengths + rule->repeatRule.rule;
+			return (ParseRuleLengths) {
+				.minLength = multiplyLength(inner->minLength, rule->repeatRule.minReps),
+				.maxLength = multiplyLength(inner->maxLength, rule->repeatRule.maxReps),
+				.canCut = inner->canCut
+			};
+		}
+		case PARSE_RULE_CUT:
+			return (ParseRuleLengths) { .minLength = 0, .maxLength = 0, .canCut = true };
+		case PARSE_RULE_TOKEN:
+		case PARSE_RULE_SKIP:
+			return (ParseRuleLengths) { .minLength = 0, .maxLength = SIZE_MAX, .canCut = false };
+		case PARSE_RULE_LAZY:
+			if(rule->lazyRule.skipRule != UINT32_MAX) {
+				return lengths[rule->lazyRule.skipRule];
+			}
+			// A balanced region is never empty.
+			return (ParseRuleLengths) { .minLength = 1, .maxLength = SIZE_MAX, .canCut = false };
+		case PARSE_RULE_OPERATOR_PRECEDENCE: {
+			// Every expression has an operand, and operators can be chained without limit.
+			ParseRuleLengths ret = lengths[rule->operatorRule.operand];
+			for(size_t i = 0; i < rule->operatorRule.numOperators; i++) {
+				ret.maxLength = SIZE_MAX;
+				ret.canCut = ret.canCut || lengths[scheme->childIndices[rule->operatorRule.firstOperator + i]].canCut;
+			}
+			return ret;
+		}
+		case PARSE_RULE_SCAN_UNTIL:
+			return (ParseRuleLengths) { .minLength = rule->scanUntilRule.required? 1 : 0, .maxLength = SIZE_MAX, .canCut = false };
+		case PARSE_RULE_SEPARATED_LIST: {
+			SeparatedListParseRule* data = &rule->separatedListRule;
+			const ParseRuleLengths* item = lengths + data->item;
+			const ParseRuleLengths* separator = lengths + data->separator;
+			size_t maxItems = (data->maxItems == UINT32_MAX)? SIZE_MAX : data->maxItems;
+			// There is a separator between every two items, and maybe one after the last.
+			size_t maxSeparators = (maxItems == 0)? 0 : (data->allowTrailing? maxItems : maxItems - 1);
+			return (ParseRuleLengths) {
+				.minLength = (data->minItems == 0)? 0
+					: addLengths(multiplyLength(item->minLength, data->minItems), multiplyLength(separator->minLength, data->minItems - 1)),
+				.maxLength = addLengths(multiplyLength(item->maxLength, maxItems), multiplyLength(separator->maxLength, maxSeparators)),
+				.canCut = item->canCut || separator->canCut
+			};
+		}
+		default:
+			return (ParseRuleLengths) { .minLength = 0, .maxLength = SIZE_MAX, .canCut = true };
+	}
+}
+
+// Returns whether any lengths grew. Children mostly come after their parents, so going backwards settles
+// non-recursive rules in a single pass.
+static bool updateLengths(ParseScheme* scheme, ParseRuleLengths* lengths) {
+	bool changed = false;
+
+	for(size_t i = scheme->numRules; i > 0; i--) {
+		ParseRuleLengths* current = lengths + i - 1;
+		ParseRuleLengths updated = getRuleLengths(scheme->rules + i - 1, lengths);
+
+		if((updated.minLength > current->minLength) || (updated.maxLength > current->maxLength) || (updated.canCut && !current->canCut)) {
+			current->minLength = (updated.minLength > current->minLength)? updated.minLength : current->minLength;
+			current->maxLength = (updated.maxLength > current->maxLength)? updated.maxLength : current->maxLength;
+			current->canCut = current->canCut || updated.canCut;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+// Lengths start at 0 and grow until every rule agrees with its children. Recursion that consumes input never
+// agrees: minimum lengths that keep growing belong to rules that can never match, and any value they have
+// reached is still a lower bound, but growing maximum lengths have no limit. Anything that depends on a
+// growing cycle grows at least once every numRules + 1 passes, so whatever still grows after that is
+// unlimited.
+bool ParseScheme_ComputeRuleLengths(ParseScheme* scheme) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		fprintf(stderr, "Error: attempting to compute rule lengths for a null scheme or one with an error.\n");
+		return false;
+	}
+
+	size_t numRules = scheme->numRules;
+	ParseRuleLengths* lengths = (ParseRuleLengths*) calloc(numRules + 1, sizeof(ParseRuleLengths));
+	size_t* maxLengths = (size_t*) malloc(sizeof(size_t) * (numRules + 1));
+
+	if((lengths == NULL) || (maxLengths == NULL)) {
+		fprintf(stderr, "Error: unable to allocate space for rule lengths!\n");
+		free(lengths);
+		free(maxLengths);
+		scheme->errorState = 2;
+		return false;
+	}
+
+	bool changed = true;
+	for(size_t pass = 0; changed && (pass < numRules + 1); pass++) {
+		changed = updateLengths(scheme, lengths);
+	}
+
+	if(changed) {
+		for(size_t i = 0; i < numRules; i++) {
+			maxLengths[i] = lengths[i].maxLength;
+		}
+
+		for(size_t pass = 0; changed && (pass < numRules + 1); pass++) {
+			changed = updateLengths(scheme, lengths);
+		}
+
+		for(size_t i = 0; i < numRules; i++) {
+			if(lengths[i].maxLength != maxLengths[i]) {
+				lengths[i].maxLength = SIZE_MAX;
+			}
+		}
+	}
+
+	free(maxLengths);
+	free(scheme->ruleLengths);
+	scheme->ruleLengths = lengths;
+	scheme->numRuleLengths = numRules;
+
+	return true;
+}
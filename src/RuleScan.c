@@ -0,0 +1,349 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "ParseFramework.h"
+#include "RuleAnalysis.h"
+#include "SimdUtil.h"
+#include "RuleScan.h"
+
+// Longer literal prefixes rarely rule out more candidates than the first few bytes already do.
+#define RULE_SCAN_MAX_PREFIX_LENGTH 32
+
+// Up to this many FIRST bytes are searched for with SimdUtil_FindAnyOf.
+#define RULE_SCAN_MAX_SIMD_BYTES 16
+
+// Buffers are only split if every thread gets at least this much of it.
+const size_t RULE_SCAN_MIN_CHUNK_LENGTH = 1 << 20;
+const size_t RULE_SCAN_MATCHES_BUFFER_LENGTH = 64;
+
+typedef struct {
+	ParseRule* rule;
+	ParseContext ctx;
+
+	char prefix[RULE_SCAN_MAX_PREFIX_LENGTH];
+	size_t prefixLen;
+
+	ByteSet first;
+	size_t numFirst;
+	char firstBytes[RULE_SCAN_MAX_SIMD_BYTES];
+} Scanner;
+
+static void Scanner_Init(Scanner* scanner, ParseRule* rule, char* buf, size_t len) {
+	scanner->rule = rule;
+	ParseContext_Init(&scanner->ctx, buf, len);
+
+	scanner->prefixLen = Rule_GetLiteralPrefix(rule, scanner->prefix, RULE_SCAN_MAX_PREFIX_LENGTH);
+
+	// Every non-empty match starts with a FIRST byte, even if the rule is nullable.
+	Rule_GetFirstSet(rule, &scanner->first);
+	scanner->numFirst = ByteSet_Count(&scanner->first);
+
+	if(scanner->numFirst <= RULE_SCAN_MAX_SIMD_BYTES) {
+		size_t n = 0;
+		for(int c = 0; c < 256; c++) {
+			if(ByteSet_Contains(&scanner->first, c)) {
+				scanner->firstBytes[n++] = (char) c;
+			}
+		}
+	}
+}
+
+// Returns the first offset in [from, to) where a match could start, or to if there is none.
+static size_t Scanner_FindCandidate(Scanner* scanner, size_t from, size_t to) {
+	char* buf = scanner->ctx.input;
+	size_t len = scanner->ctx.inputLen;
+
+	if(from >= to) {
+		return to;
+	}
+
+	if(scanner->prefixLen > 0) {
+		// The whole prefix has to fit in the buffer, but only its start has to be in the range.
+		while(from < to) {
+			char* found = memchr(buf + from, scanner->prefix[0], to - from);
+			if(found == NULL) {
+				return to;
+			}
+
+			size_t offset = found - buf;
+			if((len - offset >= scanner->prefixLen) && (memcmp(found, scanner->prefix, scanner->prefixLen) == 0)) {
+				return offset;
+			}
+			from = offset + 1;
+		}
+		return to;
+	}
+
+	if(scanner->numFirst == 0) {
+		return to;
+	}
+
+	if(scanner->numFirst == 1) {
+		char* found = memchr(buf + from, scanner->firstBytes[0], to - from);
+		return (found == NULL)? to : (size_t) (found - buf);
+	}
+
+	if(scanner->numFirst <= RULE_SCAN_MAX_SIMD_BYTES) {
+		return from + SimdUtil_FindAnyOf(buf + from, to - from, scanner->firstBytes, scanner->numFirst);
+	}
+
+	if(scanner->numFirst == 256) {
+		return from;
+	}
+
+	while((from < to) && !ByteSet_Contains(&scanner->first, (unsigned char) buf[from])) {
+		from++;
+	}
+	return from;
+}
+
+// Finds the first non-empty match that starts in [from, to).
+static bool Scanner_Next(Scanner* scanner, size_t from, size_t to, size_t* offset_ret, size_t* length_ret) {
+	while(from < to) {
+		size_t offset = Scanner_FindCandidate(scanner, from, to);
+		if(offset >= to) {
+			return false;
+		}
+
+		scanner->ctx.cutOffset = offset;
+
+		ParseResult result;
+		Rule_ParseWithContext(scanner->rule, &scanner->ctx, scanner->ctx.input + offset, &result);
+
+		if(result.success && (result.length > 0)) {
+			(*offset_ret) = offset;
+			(*length_ret) = result.length;
+			return true;
+		}
+
+		from = offset + 1;
+	}
+
+	return false;
+}
+
+size_t Rule_Scan(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, RuleScanCallback callback, void* userData) {
+	if((rule == NULL) || (buf == NULL) || (callback == NULL)) {
+		fprintf(stderr, "Error: attempting to scan with a null rule, buffer or callback.\n");
+		return 0;
+	}
+
+	Scanner scanner;
+	Scanner_Init(&scanner, rule, buf, len);
+
+	size_t numMatches = 0;
+	size_t offset, length;
+	size_t from = 0;
+
+	while(Scanner_Next(&scanner, from, len, &offset, &length)) {
+		numMatches++;
+		if(!callback(buf + offset, length, userData)) {
+			break;
+		}
+		from = (mode == RULE_SCAN_OVERLAPPING)? offset + 1 : offset + length;
+	}
+
+	ParseContext_Free(&scanner.ctx);
+
+	return numMatches;
+}
+
+typedef struct {
+	size_t offset;
+	size_t length;
+} ScanMatch;
+
+typedef struct {
+	ParseRule* rule;
+	char* buf;
+	size_t len;
+	RuleScanMode mode;
+
+	// Matches starting in [start, end) are collected. They may extend past end.
+	size_t start;
+	size_t end;
+
+	pthread_t thread;
+	bool threadStarted;
+
+	ScanMatch* matches;
+	size_t numMatches;
+	size_t maxMatches;
+
+	// Set if the matches couldn't be stored, in which case the chunk is scanned again while merging.
+	bool failed;
+} ScanChunk;
+
+static void* scanChunk(void* arg) {
+	ScanChunk* chunk = (ScanChunk*) arg;
+
+	Scanner scanner;
+	Scanner_Init(&scanner, chunk->rule, chunk->buf, chunk->len);
+
+	size_t offset, length;
+	size_t from = chunk->start;
+
+	while(Scanner_Next(&scanner, from, chunk->end, &offset, &length)) {
+		if(chunk->numMatches >= chunk->maxMatches) {
+			size_t newMax = (chunk->maxMatches == 0)? RULE_SCAN_MATCHES_BUFFER_LENGTH : chunk->maxMatches * 2;
+			ScanMatch* newMatches = (ScanMatch*) realloc(chunk->matches, newMax * sizeof(ScanMatch));
+
+			if(newMatches == NULL) {
+				chunk->failed = true;
+				break;
+			}
+
+			chunk->matches = newMatches;
+			chunk->maxMatches = newMax;
+		}
+
+		chunk->matches[chunk->numMatches++] = (ScanMatch) { .offset = offset, .length = length };
+		from = (chunk->mode == RULE_SCAN_OVERLAPPING)? offset + 1 : offset + length;
+	}
+
+	ParseContext_Free(&scanner.ctx);
+
+	return NULL;
+}
+
+typedef struct {
+	char* buf;
+	RuleScanCallback callback;
+	void* userData;
+
+	size_t numMatches;
+	size_t lastEnd;
+	bool stopped;
+} ScanMerge;
+
+static void ScanMerge_Report(ScanMerge* merge, size_t offset, size_t length) {
+	merge->numMatches++;
+	merge->lastEnd = offset + length;
+	if(!merge->callback(merge->buf + offset, length, merge->userData)) {
+		merge->stopped = true;
+	}
+}
+
+// Reports a chunk's matches in order. In non-overlapping mode, a match from the previous chunk can run into
+// this one, in which case this chunk's matches were found from the wrong starting point. The chunk is then
+// scanned again from the end of that match, until it lands on one of the chunk's own matches: from there on
+// both scans agree.
+static void ScanMerge_Chunk(ScanMerge* merge, Scanner* scanner, ScanChunk* chunk) {
+	size_t i = 0;
+
+	if(chunk->failed || ((chunk->mode == RULE_SCAN_NON_OVERLAPPING) && (merge->lastEnd > chunk->start))) {
+		size_t from = chunk->start;
+		if((chunk->mode == RULE_SCAN_NON_OVERLAPPING) && (merge->lastEnd > from)) {
+			from = merge->lastEnd;
+		}
+
+		bool synced = false;
+		size_t offset, length;
+
+		while(!synced && !merge->stopped && Scanner_Next(scanner, from, chunk->end, &offset, &length)) {
+			ScanMerge_Report(merge, offset, length);
+			from = (chunk->mode == RULE_SCAN_OVERLAPPING)? offset + 1 : offset + length;
+
+			if(!chunk->failed) {
+				while((i < chunk->numMatches) && (chunk->matches[i].offset < offset)) {
+					i++;
+				}
+				if((i < chunk->numMatches) && (chunk->matches[i].offset == offset)) {
+					i++;
+					synced = true;
+				}
+			}
+		}
+
+		if(!synced) {
+			return;
+		}
+	}
+
+	for(; (i < chunk->numMatches) && !merge->stopped; i++) {
+		ScanMerge_Report(merge, chunk->matches[i].offset, chunk->matches[i].length);
+	}
+}
+
+size_t Rule_ScanParallel(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, size_t numThreads, RuleScanCallback callback, void* userData) {
+	if((rule == NULL) || (buf == NULL) || (callback == NULL)) {
+		fprintf(stderr, "Error: attempting to scan with a null rule, buffer or callback.\n");
+		return 0;
+	}
+
+	if(numThreads == 0) {
+		long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+		numThreads = (numProcessors > 0)? (size_t) numProcessors : 1;
+	}
+
+	if(numThreads > len / RULE_SCAN_MIN_CHUNK_LENGTH) {
+		numThreads = len / RULE_SCAN_MIN_CHUNK_LENGTH;
+	}
+
+	if(numThreads <= 1) {
+		return Rule_Scan(rule, buf, len, mode, callback, userData);
+	}
+
+	ScanChunk* chunks = (ScanChunk*) calloc(numThreads, sizeof(ScanChunk));
+
+	if(chunks == NULL) {
+		return Rule_Scan(rule, buf, len, mode, callback, userData);
+	}
+
+	for(size_t i = 0; i < numThreads; i++) {
+		chunks[i] = (ScanChunk) {
+			.rule = rule,
+			.buf = buf,
+			.len = len,
+			.mode = mode,
+			.start = len / numThreads * i,
+			.end = (i + 1 == numThreads)? len : len / numThreads * (i + 1),
+			.threadStarted = false,
+			.matches = NULL,
+			.numMatches = 0,
+			.maxMatches = 0,
+			.failed = false
+		};
+	}
+
+	// The first chunk is scanned on this thread. A chunk whose thread couldn't be started is marked as
+	// failed, so it gets scanned while merging instead.
+	for(size_t i = 1; i < numThreads; i++) {
+		chunks[i].threadStarted = (pthread_create(&chunks[i].thread, NULL, scanChunk, &chunks[i]) == 0);
+		chunks[i].failed = !chunks[i].threadStarted;
+	}
+	scanChunk(&chunks[0]);
+
+	for(size_t i = 1; i < numThreads; i++) {
+		if(chunks[i].threadStarted) {
+			pthread_join(chunks[i].thread, NULL);
+		}
+	}
+
+	Scanner scanner;
+	Scanner_Init(&scanner, rule, buf, len);
+
+	ScanMerge merge = {
+		.buf = buf,
+		.callback = callback,
+		.userData = userData,
+		.numMatches = 0,
+		.lastEnd = 0,
+		.stopped = false
+	};
+
+	for(size_t i = 0; (i < numThreads) && !merge.stopped; i++) {
+		ScanMerge_Chunk(&merge, &scanner, &chunks[i]);
+	}
+
+	ParseContext_Free(&scanner.ctx);
+
+	for(size_t i = 0; i < numThreads; i++) {
+		free(chunks[i].matches);
+	}
+	free(chunks);
+
+	return merge.numMatches;
+}
@@ -37,30 +37,24 @@ ParseRule* RulesListRuleData_Create(ParseScheme* scheme, va_list varArgs, ParseR
 		}
 
 		
-		RulesListRuleData* ruleData = (RulesListRuleData*) malloc(sizeof(RulesListRuleData));
-		ParseRule** rulesList = (ParseRule**) malloc(sizeof(ParseRule*) * numRules);
-
-		if((ruleData == NULL) || (rulesList == NULL)) {
-			fprintf(stderr, "Error: unable to allocate Rule List rule!\n");
-
-			free(rulesList);
-			free(ruleData);
-			ParseScheme_Free(scheme);
-			scheme->errorState = 2;	
+		uint32_t firstRule = ParseScheme_AddRulesList(scheme, ruleBuffer, numRules);
 
+		if(firstRule == UINT32_MAX) {
 			return NULL;
 		}
 
-		memcpy(rulesList, ruleBuffer, sizeof(ParseRule*) * numRules);
-
-		ruleData->rules = rulesList;
-		ruleData->rulesLen = numRules;
+		RulesListRuleData ruleData = {
+			.firstRule = firstRule,
+			.rulesLen = (uint32_t) numRules,
+			.skip = (ruleType == PARSE_RULE_SEQUENCE) && scheme->skipping
+		};
 		if(ruleType == PARSE_RULE_OPTION_LIST) {
 			ret->optionListRule = ruleData;
 		} else if(ruleType == PARSE_RULE_SEQUENCE){
 			ret->sequenceRule = ruleData;
 		}
 		ret->ruleType = ruleType;
+		ret = ParseScheme_InternRule(scheme, ret);
 
 		// If there are still more rules to parse, make this rule list rule be a child of a new rule list rule
 		// and continue parsing the arguments.
@@ -81,30 +75,24 @@ ParseRule* RulesListRuleData_Create(ParseScheme* scheme, va_list varArgs, ParseR
 	return ret;
 }
 
-void RulesListRuleData_Free(RulesListRuleData* data) {
-	if(data == NULL) return;
-			
-	free(data->rules);
-	data->rules = NULL;
-	free(data);
-}
+void RulesListRuleData_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+	size_t rulesLen = rule->sequenceRule.rulesLen;
 
-void RulesListRuleData_PrintDeep(RulesListRuleData* data, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
 	fprintf(fout, "(");
-	if(data->rulesLen > 0) {
-		Rule_PrintSimpleRulePointer(data->rules[0], fout);
+	if(rulesLen > 0) {
+		Rule_PrintSimpleRulePointer(Rule_GetListRule(rule, 0), fout);
 		//fprintf(fout, "%p", data->rules[0]);
 	}
-	for(size_t i = 1; i < data->rulesLen; i++) {
+	for(size_t i = 1; i < rulesLen; i++) {
 		fprintf(fout, ", ");
-		Rule_PrintSimpleRulePointer(data->rules[i], fout);
+		Rule_PrintSimpleRulePointer(Rule_GetListRule(rule, i), fout);
 	}
 	fprintf(fout, ")");
 
 	if(depth < maxDepth) {
-		for(size_t i = 0; i < data->rulesLen; i++) {
+		for(size_t i = 0; i < rulesLen; i++) {
 			fprintf(fout, "\n");
-			Rule_PrintDeep(data->rules[i], fout, depth + 1, maxDepth, indentStr);
+			Rule_PrintDeep(Rule_GetListRule(rule, i), fout, depth + 1, maxDepth, indentStr);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "SimdUtil.h"
+#include "ScanUntilParseRule.h"
+
+ParseRule* ScanUntilRule_Create(ParseScheme* scheme, const char* stops, char escape, bool required) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if(stops == NULL) {
+		fprintf(stderr, "Error: attempting to create a scan rule with null stop bytes.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
+	size_t numStops = strlen(stops);
+
+	if((numStops + ((escape != 0)? 1 : 0) > SCAN_UNTIL_MAX_STOPS) || ((escape != 0) && (strchr(stops, escape) != NULL))) {
+		fprintf(stderr, "Error: a scan rule can stop at up to %d bytes including its escape byte, which can't be a stop byte.\n", SCAN_UNTIL_MAX_STOPS);
+		ParseScheme_Free(scheme);
+		scheme->errorState = 4;
+		return NULL;
+	}
+
+	// The escape byte is stored after the stop bytes, so that both can be searched for at once.
+	char searchBytes[SCAN_UNTIL_MAX_STOPS + 1];
+	memcpy(searchBytes, stops, numStops);
+	searchBytes[numStops] = escape;
+
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+	uint32_t stopsOffset = (ret != NULL)? ParseScheme_AddString(scheme, searchBytes, numStops + ((escape != 0)? 1 : 0)) : UINT32_MAX;
+
+	if(stopsOffset == UINT32_MAX) {
+		return NULL;
+	}
+
+	ret->scanUntilRule = (ScanUntilParseRule) {
+		.stops = stopsOffset,
+		.numStops = (uint32_t) numStops,
+		.escape = escape,
+		.required = required
+	};
+
+	ret->ruleType = PARSE_RULE_SCAN_UNTIL;
+
+	return ret;
+}
+
+ParseResult ScanUntilRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	ScanUntilParseRule* data = &rule->scanUntilRule;
+	const char* searchBytes = rule->scheme->stringPool + data->stops;
+	size_t numSearchBytes = data->numStops + ((data->escape != 0)? 1 : 0);
+	size_t len = (ctx->input + ctx->inputLen) - str;
+	size_t i = 0;
+
+	while(true) {
+		if(numSearchBytes == 1) {
+			char* found = memchr(str + i, searchBytes[0], len - i);
+			i = (found == NULL)? len : (size_t) (found - str);
+		} else {
+			i += SimdUtil_FindAnyOf(str + i, len - i, searchBytes, numSearchBytes);
+		}
+
+		if((i < len) && (str[i] == data->escape) && (data->escape != 0)) {
+			if(i + 1 < len) {
+				i += 2;
+				continue;
+			}
+			// An escape byte with nothing after it isn't matched, but the end of the input was looked at.
+			ParseContext_MarkExamined(ctx, str, len + 1);
+			break;
+		}
+
+		// Whether the scan found a stop byte or ran into the end of the input, it looked one byte further.
+		ParseContext_MarkExamined(ctx, str, i + 1);
+		break;
+	}
+
+	if(data->required && (i == 0)) {
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	return setParseResult(result_ret, true, str, i);
+}
+
+void ScanUntilRule_Print(ParseRule* rule, FILE* fout) {
+	ScanUntilParseRule* data = &rule->scanUntilRule;
+
+	fprintf(fout, "ScanUntil(\"%.*s\"", (int) data->numStops, rule->scheme->stringPool + data->stops);
+	if(data->escape != 0) {
+		fprintf(fout, ", '%c'", data->escape);
+	}
+	fprintf(fout, "%s)", data->required? ", required" : "");
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "ParseFramework.h"
+#include "ParseEvents.h"
+#include "SeparatedListParseRule.h"
+
+ParseRule* SeparatedListRule_Create(ParseScheme* scheme, ParseRule* item, ParseRule* separator, size_t minItems, size_t maxItems, bool allowTrailing) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	if((item == NULL) || (separator == NULL)) {
+		fprintf(stderr, "Error: attempting to create a separated list with a null item or separator.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
+	if((minItems > maxItems) || (minItems >= UINT32_MAX)) {
+		fprintf(stderr, "Error: a separated list needs at most as many items as its maximum, and fewer than %u.\n", UINT32_MAX);
+		ParseScheme_Free(scheme);
+		scheme->errorState = 4;
+		return NULL;
+	}
+
+	uint32_t itemIndex = Rule_GetIndex(item);
+	uint32_t separatorIndex = Rule_GetIndex(separator);
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->separatedListRule = (SeparatedListParseRule) {
+		.item = itemIndex,
+		.separator = separatorIndex,
+		.minItems = (uint32_t) minItems,
+		.maxItems = (maxItems >= UINT32_MAX)? UINT32_MAX : (uint32_t) maxItems,
+		.allowTrailing = allowTrailing
+	};
+
+	ret->ruleType = PARSE_RULE_SEPARATED_LIST;
+
+	return ret;
+}
+
+static ParseResult parseList(ParseRule* rule, ParseContext* ctx, char* str, size_t* offsets_ret, size_t maxOffsets, size_t* numItems_ret, ParseResult* result_ret) {
+	SeparatedListParseRule* data = &rule->separatedListRule;
+	ParseRule* item = Rule_GetItemRule(rule);
+	ParseRule* separator = Rule_GetSeparatorRule(rule);
+	size_t strIndex = 0;
+	size_t numItems = 0;
+	bool cut = false;
+	ParseResult res;
+
+	(*numItems_ret) = 0;
+
+	if(data->maxItems > 0) {
+		if(Rule_ParseWithContext(item, ctx, str, &res).success) {
+			if(maxOffsets > 0) {
+				offsets_ret[0] = 0;
+			}
+			strIndex = res.length;
+			numItems = 1;
+			cut = res.cut;
+		} else if(res.cut) {
+			return setParseResultWithCut(result_ret, false, NULL, 0, true);
+		}
+	}
+
+	while((numItems > 0) && ((numItems < data->maxItems) || data->allowTrailing)) {
+		size_t pendingMark = (ctx->events != NULL)? ctx->events->numPending : 0;
+
+		if(!Rule_ParseWithContext(separator, ctx, str + strIndex, &res).success) {
+			if(res.cut) {
+				return setParseResultWithCut(result_ret, false, NULL, 0, true);
+			}
+			break;
+		}
+
+		size_t itemStart = strIndex + res.length;
+		bool separatorCut = res.cut;
+
+		if(numItems == data->maxItems) {
+			strIndex = itemStart;
+			cut = cut || separatorCut;
+			break;
+		}
+
+		if(Rule_ParseWithContext(item, ctx, str + itemStart, &res).success) {
+			if(itemStart + res.length == strIndex) {
+				// Nothing was matched, so every further item would be the same one again.
+				if(ctx->events != NULL) {
+					ParseEvents_Retract(ctx->events, pendingMark);
+				}
+				break;
+			}
+
+			if(numItems < maxOffsets) {
+				offsets_ret[numItems] = itemStart;
+			}
+			strIndex = itemStart + res.length;
+			numItems++;
+			cut = cut || separatorCut || res.cut;
+			continue;
+		}
+
+		// Same as a repeated (separator item) sequence: past a cut in either one, the list can't end early.
+		if(res.cut || separatorCut) {
+			return setParseResultWithCut(result_ret, false, NULL, 0, true);
+		}
+
+		if(data->allowTrailing) {
+			strIndex = itemStart;
+		} else if(ctx->events != NULL) {
+			ParseEvents_Retract(ctx->events, pendingMark);
+		}
+		break;
+	}
+
+	if(numItems < data->minItems) {
+		return setParseResultWithCut(result_ret, false, NULL, 0, cut);
+	}
+
+	(*numItems_ret) = numItems;
+	return setParseResultWithCut(result_ret, true, str, strIndex, cut);
+}
+
+ParseResult SeparatedListRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	size_t numItems;
+	return parseList(rule, ctx, str, NULL, 0, &numItems, result_ret);
+}
+
+ParseResult SeparatedListRule_ParseItems(ParseRule* rule, ParseContext* ctx, char* str, size_t* offsets_ret, size_t maxOffsets, size_t* numItems_ret, ParseResult* result_ret) {
+	if((rule == NULL) || (ctx == NULL) || (str == NULL) || (numItems_ret == NULL) || ((offsets_ret == NULL) && (maxOffsets > 0))) {
+		fprintf(stderr, "Error: attempting to parse the items of a separated list with a null argument.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	if(rule->ruleType != PARSE_RULE_SEPARATED_LIST) {
+		fprintf(stderr, "Error: attempting to parse the items of a rule that isn't a separated list.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	return parseList(rule, ctx, str, offsets_ret, maxOffsets, numItems_ret, result_ret);
+}
+
+void SeparatedListRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+	SeparatedListParseRule* data = &rule->separatedListRule;
+
+	fprintf(fout, "SeparatedList(");
+	Rule_PrintSimpleRulePointer(Rule_GetItemRule(rule), fout);
+	fprintf(fout, ", ");
+	Rule_PrintSimpleRulePointer(Rule_GetSeparatorRule(rule), fout);
+	if(data->maxItems == UINT32_MAX) {
+		fprintf(fout, ", %u+", data->minItems);
+	} else {
+		fprintf(fout, ", %u-%u", data->minItems, data->maxItems);
+	}
+	fprintf(fout, "%s)", data->allowTrailing? ", trailing" : "");
+
+	if(depth < maxDepth) {
+		Rule_PrintDeep(Rule_GetItemRule(rule), fout, depth + 1, maxDepth, indentStr);
+		Rule_PrintDeep(Rule_GetSeparatorRule(rule), fout, depth + 1, maxDepth, indentStr);
+	}
+}
+
+void SeparatedListRule_Print(ParseRule* rule, FILE* fout) {
+	SeparatedListRule_PrintDeep(rule, fout, 0, 0, "");
+}
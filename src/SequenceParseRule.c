@@ -3,6 +3,7 @@
 #include <stdarg.h>
 #include "ParseFramework.h"
 #include "RulesListRuleUtil.h"
+#include "SkipParseRule.h"
 
 ParseRule* createSequenceRule(ParseScheme* scheme, ...) {
 	if((scheme == NULL) || (scheme->errorState != 0)) {
@@ -19,40 +20,56 @@ ParseRule* createSequenceRule(ParseScheme* scheme, ...) {
 	return ret;
 }
 
-void SequenceRule_Free(SequenceParseRule* rule) {
-	RulesListRuleData_Free(rule);
-}
-
-ParseResult SequenceRule_Parse(SequenceParseRule* rule, char* str, ParseResult* result_ret) {
+ParseResult SequenceRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	if(rule == NULL) {
 		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
 	size_t strIndex = 0;
+	bool cut = false;
+	size_t available = (ctx->input + ctx->inputLen) - str;
+
+	if(Rule_CannotMatchWithin(rule, available)) {
+		// Failing depends on where the input ends.
+		ParseContext_MarkExamined(ctx, ctx->input + ctx->inputLen, 1);
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	for(size_t i = 0; i < rule->sequenceRule.rulesLen; i++) {
+		if(rule->sequenceRule.skip) {
+			strIndex += SkipRule_Skip(rule->scheme, ctx, str + strIndex);
+		}
+
+		ParseRule* element = Rule_GetListRule(rule, i);
+		if(Rule_CannotMatchWithin(element, available - strIndex)) {
+			ParseContext_MarkExamined(ctx, ctx->input + ctx->inputLen, 1);
+			return setParseResultWithCut(result_ret, false, NULL, 0, cut);
+		}
 
-	for(size_t i = 0; i < rule->rulesLen; i++) {
 		ParseResult result;
-		if(!(Rule_Parse(rule->rules[i], str + strIndex, &result).success)) {
-			return setParseResult(result_ret, false, NULL, 0);
+		if(!(Rule_ParseWithContext(element, ctx, str + strIndex, &result).success)) {
+			// If an earlier element of the sequence was cut, this failure is committed as well.
+			return setParseResultWithCut(result_ret, false, NULL, 0, cut || result.cut);
 		}
 
 		strIndex += result.length;
+		cut = cut || result.cut;
 	}
 
-	return setParseResult(result_ret, true, str, strIndex);
+	return setParseResultWithCut(result_ret, true, str, strIndex, cut);
 }
 
-void SequenceRule_PrintDeep(SequenceParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
+void SequenceRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr) {
 	// for(size_t i = 0; i < depth; i++) {
 	// 	fprintf(fout, "%s", indentStr);
 	// }
 
-	fprintf(fout, "Sequence");
+	fprintf(fout, rule->sequenceRule.skip? "SkipSequence" : "Sequence");
 	RulesListRuleData_PrintDeep(rule, fout, depth, maxDepth, indentStr);
 }
 
-void SequenceRule_Print(SequenceParseRule* rule, FILE* fout) {
+void SequenceRule_Print(ParseRule* rule, FILE* fout) {
 	SequenceRule_PrintDeep(rule, fout, 0, 0, "");
 }
 
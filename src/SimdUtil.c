@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "SimdUtil.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+bool SimdUtil_EqualsFolded(const char* str, const char* lowercase, size_t len) {
+	size_t i = 0;
+
+#ifdef __SSE2__
+	// Shifting 'A'..'Z' to the bottom of the signed range lets a single signed compare find the uppercase
+	// letters, which then get the lowercase bit set.
+	const __m128i shift = _mm_set1_epi8((char) (0x80 - 'A'));
+	const __m128i upperLimit = _mm_set1_epi8((char) (0x80 + 26));
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+
+	for(; i + 16 <= len; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*) (str + i));
+		__m128i expected = _mm_loadu_si128((const __m128i*) (lowercase + i));
+
+		__m128i isUpper = _mm_cmplt_epi8(_mm_add_epi8(chunk, shift), upperLimit);
+		__m128i folded = _mm_or_si128(chunk, _mm_and_si128(isUpper, caseBit));
+
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, expected)) != 0xFFFF) {
+			return false;
+		}
+	}
+#endif
+
+	// Without branching on each byte, collect any difference and check it once at the end.
+	unsigned char difference = 0;
+	for(; i < len; i++) {
+		difference |= SIMD_FOLD_ASCII_CASE((unsigned char) str[i]) ^ (unsigned char) lowercase[i];
+	}
+
+	return difference == 0;
+}
+
+size_t SimdUtil_FindAnyOf(const char* str, size_t len, const char* bytes, size_t numBytes) {
+	size_t i = 0;
+
+#ifdef __SSE2__
+	__m128i needles[16];
+	for(size_t j = 0; j < numBytes; j++) {
+		needles[j] = _mm_set1_epi8(bytes[j]);
+	}
+
+	for(; i + 16 <= len; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*) (str + i));
+		__m128i found = _mm_setzero_si128();
+
+		for(size_t j = 0; j < numBytes; j++) {
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, needles[j]));
+		}
+
+		int mask = _mm_movemask_epi8(found);
+		if(mask != 0) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+	for(; i < len; i++) {
+		for(size_t j = 0; j < numBytes; j++) {
+			if(str[i] == bytes[j]) {
+				return i;
+			}
+		}
+	}
+
+	return len;
+}
+
+size_t SimdUtil_SkipAnyOf(const char* str, size_t len, const char* bytes, size_t numBytes) {
+	size_t i = 0;
+
+#ifdef __SSE2__
+	__m128i needles[16];
+	for(size_t j = 0; j < numBytes; j++) {
+		needles[j] = _mm_set1_epi8(bytes[j]);
+	}
+
+	for(; i + 16 <= len; i += 16) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*) (str + i));
+		__m128i found = _mm_setzero_si128();
+
+		for(size_t j = 0; j < numBytes; j++) {
+			found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, needles[j]));
+		}
+
+		int mask = _mm_movemask_epi8(found) ^ 0xFFFF;
+		if(mask != 0) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+	for(; i < len; i++) {
+		bool found = false;
+		for(size_t j = 0; j < numBytes; j++) {
+			found |= (str[i] == bytes[j]);
+		}
+		if(!found) {
+			return i;
+		}
+	}
+
+	return len;
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ParseFramework.h"
+#include "SimdUtil.h"
+#include "SkipParseRule.h"
+
+bool ParseScheme_SetSkipper(ParseScheme* scheme, const char* whitespace, const char* lineComment, const char* blockCommentStart, const char* blockCommentEnd) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return false;
+	}
+
+	// Like adding a rule to a finalized scheme, this is misuse of the scheme rather than a bad argument, so the
+	// scheme is kept.
+	if(scheme->finalized) {
+		fprintf(stderr, "Error: attempting to change the skipper of a finalized scheme.\n");
+		scheme->errorState = 4;
+		return false;
+	}
+
+	if((whitespace == NULL) || ((blockCommentStart == NULL) != (blockCommentEnd == NULL))) {
+		fprintf(stderr, "Error: a skipper needs whitespace, and both or neither block comment delimiters.\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return false;
+	}
+
+	size_t numSkipBytes = strlen(whitespace);
+	bool emptyDelimiter = ((lineComment != NULL) && (lineComment[0] == 0))
+		|| ((blockCommentStart != NULL) && ((blockCommentStart[0] == 0) || (blockCommentEnd[0] == 0)));
+
+	if((numSkipBytes > PARSE_SKIP_MAX_BYTES) || emptyDelimiter) {
+		fprintf(stderr, "Error: a skipper can skip at most %d different bytes, and comment delimiters can't be empty.\n", PARSE_SKIP_MAX_BYTES);
+		ParseScheme_Free(scheme);
+		scheme->errorState = 4;
+		return false;
+	}
+
+	uint32_t line = (lineComment == NULL)? UINT32_MAX : ParseScheme_AddString(scheme, lineComment, strlen(lineComment));
+	uint32_t blockStart = (blockCommentStart == NULL)? UINT32_MAX : ParseScheme_AddString(scheme, blockCommentStart, strlen(blockCommentStart));
+	uint32_t blockEnd = (blockCommentEnd == NULL)? UINT32_MAX : ParseScheme_AddString(scheme, blockCommentEnd, strlen(blockCommentEnd));
+
+	if(scheme->errorState != 0) {
+		return false;
+	}
+
+	memcpy(scheme->skipBytes, whitespace, numSkipBytes);
+	scheme->numSkipBytes = numSkipBytes;
+	scheme->skipLineComment = line;
+	scheme->skipBlockCommentStart = blockStart;
+	scheme->skipBlockCommentEnd = blockEnd;
+	scheme->skipping = true;
+
+	return true;
+}
+
+void ParseScheme_SetSkipping(ParseScheme* scheme, bool skipping) {
+	if(scheme == NULL) {
+		return;
+	}
+
+	scheme->skipping = skipping;
+}
+
+ParseRule* SkipRule_Create(ParseScheme* scheme) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	// The skipper belongs to the scheme, so there is nothing to allocate.
+	ret->ruleType = PARSE_RULE_SKIP;
+
+	return ret;
+}
+
+static bool startsWith(const char* str, size_t len, const char* prefix) {
+	size_t prefixLen = strlen(prefix);
+	return (prefixLen <= len) && (memcmp(str, prefix, prefixLen) == 0);
+}
+
+// Returns the offset of the first occurrence of needle in str, or len if there is none.
+static size_t findString(const char* str, size_t len, const char* needle) {
+	size_t needleLen = strlen(needle);
+
+	for(size_t i = 0; i + needleLen <= len; i++) {
+		const char* found = memchr(str + i, needle[0], len - i - needleLen + 1);
+		if(found == NULL) {
+			break;
+		}
+
+		i = found - str;
+		if(memcmp(found, needle, needleLen) == 0) {
+			return i;
+		}
+	}
+
+	return len;
+}
+
+size_t SkipRule_Skip(ParseScheme* scheme, ParseContext* ctx, char* str) {
+	size_t len = (ctx->input + ctx->inputLen) - str;
+	const char* lineComment = (scheme->skipLineComment == UINT32_MAX)? NULL : scheme->stringPool + scheme->skipLineComment;
+	const char* blockStart = (scheme->skipBlockCommentStart == UINT32_MAX)? NULL : scheme->stringPool + scheme->skipBlockCommentStart;
+	const char* blockEnd = (scheme->skipBlockCommentEnd == UINT32_MAX)? NULL : scheme->stringPool + scheme->skipBlockCommentEnd;
+
+	size_t i = 0;
+	size_t examined = 0;
+
+	while(true) {
+		i += SimdUtil_SkipAnyOf(str + i, len - i, scheme->skipBytes, scheme->numSkipBytes);
+
+		if((lineComment != NULL) && startsWith(str + i, len - i, lineComment)) {
+			// The newline is left for the whitespace, if it is skipped at all.
+			char* newline = memchr(str + i, '\n', len - i);
+			i = (newline == NULL)? len : (size_t) (newline - str);
+			continue;
+		}
+
+		if((blockStart != NULL) && startsWith(str + i, len - i, blockStart)) {
+			size_t from = i + strlen(blockStart);
+			size_t end = from + findString(str + from, len - from, blockEnd);
+
+			// An unterminated comment isn't skipped, but it would be if the input went on to end it.
+			if(end < len) {
+				i = end + strlen(blockEnd);
+				continue;
+			}
+			examined = len + 1;
+		}
+
+		break;
+	}
+
+	// The byte that stopped the skipping was looked at too, along with enough of it to rule out a comment. If
+	// that runs past the end of the input, the end was looked at, like any other rule that runs into it.
+	size_t lookahead = 1;
+	if((lineComment != NULL) && (strlen(lineComment) > lookahead)) {
+		lookahead = strlen(lineComment);
+	}
+	if((blockStart != NULL) && (strlen(blockStart) > lookahead)) {
+		lookahead = strlen(blockStart);
+	}
+	if(examined < i + lookahead) {
+		examined = (i + lookahead <= len)? i + lookahead : len + 1;
+	}
+	ParseContext_MarkExamined(ctx, str, examined);
+
+	return i;
+}
+
+ParseResult SkipRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	return setParseResult(result_ret, true, str, SkipRule_Skip(rule->scheme, ctx, str));
+}
+
+void SkipRule_Print(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "Skip");
+}
@@ -2,12 +2,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ParseFramework.h"
+#include "SimdUtil.h"
 
-ParseRule* StringRule_Create(ParseScheme* scheme, char* str) {
+static ParseRule* createStringRule(ParseScheme* scheme, char* str, bool caseInsensitive) {
 	if((scheme == NULL) || (scheme->errorState != 0)) {
 		return NULL;
 	}
 
+	if(str == NULL) {
+		fprintf(stderr, "Error: attempting to create a string rule from a null string!\n");
+		ParseScheme_Free(scheme);
+		scheme->errorState = 3;
+		return NULL;
+	}
+
 	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
 
 	if(ret == NULL) {
@@ -15,49 +23,60 @@ ParseRule* StringRule_Create(ParseScheme* scheme, char* str) {
 	}
 
 	size_t stringLen = strlen(str);
+	uint32_t offset = ParseScheme_AddString(scheme, str, stringLen);
 
-	StringParseRule* ruleData = (StringParseRule*) malloc(sizeof(StringParseRule));
-	char* strCopy = (char*) malloc(sizeof(char) * stringLen);
-
-	if((ruleData == NULL) || (strCopy == NULL)) {
-		fprintf(stderr, "Error: unable to allocate string rule!\n");
-
-		free(ruleData);
-		free(strCopy);
-
-		ParseScheme_Free(scheme);
-		scheme->errorState = 2;
-
+	if(offset == UINT32_MAX) {
 		return NULL;
 	}
 
-	memcpy(strCopy, str, sizeof(char) * stringLen);
-
-	ruleData->stringLen = stringLen;
-	ruleData->string = strCopy;
+	if(caseInsensitive) {
+		for(size_t i = 0; i < stringLen; i++) {
+			scheme->stringPool[offset + i] = SIMD_FOLD_ASCII_CASE(str[i]);
+		}
+	}
 
-	ret->stringRule = ruleData;
+	ret->stringRule = (StringParseRule) {
+		.string = offset,
+		.stringLen = (uint32_t) stringLen,
+		.caseInsensitive = caseInsensitive
+	};
 	ret->ruleType = PARSE_RULE_STRING;
 
-	return ret;
+	return ParseScheme_InternRule(scheme, ret);
 }
 
-void StringRule_Free(StringParseRule* rule) {
-	if(rule == NULL) return;
-	
-	free(rule->string);
-	rule->string = NULL;
-	free(rule);
+ParseRule* StringRule_Create(ParseScheme* scheme, char* str) {
+	return createStringRule(scheme, str, false);
 }
 
-ParseResult StringRule_Parse(StringParseRule* rule, char* str, ParseResult* result_ret) {
+ParseRule* StringRule_CreateCaseInsensitive(ParseScheme* scheme, char* str) {
+	return createStringRule(scheme, str, true);
+}
+
+ParseResult StringRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
 	if(rule == NULL) {
 		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
 		return setParseResult(result_ret, false, NULL, 0);
 	}
 
-	if(strncmp(str, rule->string, rule->stringLen) == 0) {
-		return setParseResult(result_ret, true, str, rule->stringLen);
+	StringParseRule* data = &rule->stringRule;
+	size_t remainingLen = (ctx->input + ctx->inputLen) - str;
+
+	if(remainingLen < data->stringLen) {
+		// Seeing the end of the input is what made the match fail.
+		ParseContext_MarkExamined(ctx, str, remainingLen + 1);
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	ParseContext_MarkExamined(ctx, str, data->stringLen);
+
+	const char* string = Rule_GetText(rule);
+	bool matches = data->caseInsensitive?
+		SimdUtil_EqualsFolded(str, string, data->stringLen) :
+		(memcmp(str, string, data->stringLen) == 0);
+
+	if(matches) {
+		return setParseResult(result_ret, true, str, data->stringLen);
 	} else {
 		return setParseResult(result_ret, false, NULL, 0);
 	}
@@ -72,6 +91,6 @@ ParseResult StringRule_Parse(StringParseRule* rule, char* str, ParseResult* resu
 // 	fprintf(fout, "String(\"%s\")", rule->string);
 // }
 
-void StringRule_Print(StringParseRule* rule, FILE* fout) {
-	fprintf(fout, "String(\"%s\")", rule->string);
+void StringRule_Print(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "%s(\"%s\")", rule->stringRule.caseInsensitive? "StringCaseInsensitive" : "String", Rule_GetText(rule));
 }
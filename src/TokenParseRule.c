@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ParseFramework.h"
+
+ParseRule* TokenRule_Create(ParseScheme* scheme, int tokenType) {
+	if((scheme == NULL) || (scheme->errorState != 0)) {
+		return NULL;
+	}
+
+	ParseRule* ret = getSchemeSpaceForNewRule(scheme);
+
+	if(ret == NULL) {
+		return NULL;
+	}
+
+	ret->tokenRule.tokenType = tokenType;
+
+	ret->ruleType = PARSE_RULE_TOKEN;
+
+	return ret;
+}
+
+ParseResult TokenRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret) {
+	if(rule == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a null rule.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	if(ctx->tokens == NULL) {
+		fprintf(stderr, "Error: attempting to parse using a token rule on input that wasn't tokenized.\n");
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	size_t offset = str - ctx->input;
+	ParseContext_MarkExamined(ctx, str, 1);
+
+	int32_t tokenIndex = ctx->tokens->tokenAtOffset[offset];
+
+	if((tokenIndex < 0) || (ctx->tokens->tokens[tokenIndex].tokenType != rule->tokenRule.tokenType)) {
+		return setParseResult(result_ret, false, NULL, 0);
+	}
+
+	Token* token = ctx->tokens->tokens + tokenIndex;
+	ParseContext_MarkExamined(ctx, str, (token->offset + token->length) - offset);
+
+	// Consume the token along with any skipped input in front of it.
+	return setParseResult(result_ret, true, str, (token->offset + token->length) - offset);
+}
+
+void TokenRule_Print(ParseRule* rule, FILE* fout) {
+	fprintf(fout, "Token(%d)", rule->tokenRule.tokenType);
+}
@@ -5,12 +5,11 @@
 #include "ParseFramework.h"
 
 ParseRule* AlphabetRule_Create(ParseScheme* scheme, char* str);
+ParseRule* AlphabetRule_CreateCaseInsensitive(ParseScheme* scheme, char* str);
 
-void AlphabetRule_Free(AlphabetParseRule* rule);
+ParseResult AlphabetRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult AlphabetRule_Parse(AlphabetParseRule* rule, char* str, ParseResult* result_ret);
-
-// void AlphabetRule_PrintDeep(AlphabetParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
-void AlphabetRule_Print(AlphabetParseRule* rule, FILE* fout);
+// void AlphabetRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void AlphabetRule_Print(ParseRule* rule, FILE* fout);
 
 #endif
\ No newline at end of file
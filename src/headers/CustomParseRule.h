@@ -0,0 +1,9 @@
+#ifndef EKW_PARSER_CUSTOM_PARSE_RULE_H
+#define EKW_PARSER_CUSTOM_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+ParseRule* CustomRule_Create(ParseScheme* scheme, ParseRuleType ruleType, void* data);
+
+#endif
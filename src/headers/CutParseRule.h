@@ -0,0 +1,13 @@
+#ifndef EKW_PARSER_CUT_PARSE_RULE_H
+#define EKW_PARSER_CUT_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+ParseRule* CutRule_Create(ParseScheme* scheme);
+
+ParseResult CutRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+void CutRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef EKW_PARSER_INCREMENTAL_PARSER_H
+#define EKW_PARSER_INCREMENTAL_PARSER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// An incremental parser keeps its own copy of a document and the memo from parsing it, so that after a small
+// edit, only the rules that looked at the edited bytes are parsed again. Token rules aren't supported, since
+// the document isn't tokenized.
+IncrementalParser* IncrementalParser_Create(ParseRule* rule, const char* text, size_t textLen);
+
+void IncrementalParser_Free(IncrementalParser* parser);
+
+// Parses the current text. The result points into the parser's text, so it is only valid until the next
+// edit.
+ParseResult IncrementalParser_Parse(IncrementalParser* parser, ParseResult* result_ret);
+
+// Replaces removedLen bytes at offset with the inserted bytes.
+bool IncrementalParser_Edit(IncrementalParser* parser, size_t offset, size_t removedLen, const char* inserted, size_t insertedLen);
+
+#endif
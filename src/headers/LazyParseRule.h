@@ -0,0 +1,24 @@
+#ifndef EKW_PARSER_LAZY_PARSE_RULE_H
+#define EKW_PARSER_LAZY_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+// Lazy rules only find the extent of a region, and leave parsing it with rule for later. A balanced region
+// runs from open to its matching close. quote and escape can be 0.
+ParseRule* LazyRule_CreateBalanced(ParseScheme* scheme, char open, char close, char quote, char escape, ParseRule* rule);
+
+// The region is whatever skipRule matches. skipRule should be much cheaper to parse than rule, e.g. regular.
+ParseRule* LazyRule_CreateWithSkip(ParseScheme* scheme, ParseRule* skipRule, ParseRule* rule);
+
+ParseResult LazyRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+// Parses a region that the lazy rule matched, starting at str and length bytes long, with its inner rule, which
+// sees the region as if the input ended there. Fails unless the inner rule matches the whole region. To get the region's tree, parse it with ParseTree_Parse and
+// Rule_GetInnerRule(rule) instead.
+ParseResult LazyRule_Expand(ParseRule* rule, ParseContext* ctx, char* str, size_t length, ParseResult* result_ret);
+
+void LazyRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void LazyRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef EKW_PARSER_LEXER_H
+#define EKW_PARSER_LEXER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// A lexer splits input into tokens in a single pass, using a DFA built from its token rules. At each offset
+// it takes the longest match, preferring the token that was added first when two matches are equally long.
+// Token rules have to be regular (see ParseDfa_IsRegular).
+Lexer* Lexer_Create();
+
+void Lexer_Free(Lexer* lexer);
+
+bool Lexer_AddToken(Lexer* lexer, int tokenType, ParseRule* rule);
+
+// Skipped input, such as whitespace, is matched like a token but left out of the token stream.
+bool Lexer_AddSkip(Lexer* lexer, ParseRule* rule);
+
+TokenStream* Lexer_Tokenize(Lexer* lexer, char* input, size_t inputLen);
+
+void TokenStream_Free(TokenStream* tokens);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef EKW_PARSER_OPERATOR_PRECEDENCE_PARSE_RULE_H
+#define EKW_PARSER_OPERATOR_PRECEDENCE_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+// Matches expressions of operands joined by operators, with the operators grouped by precedence and
+// associativity, in one loop instead of a rule per precedence level. Operators are tried in the order given,
+// and the first one that matches is the one used, so an operator that is a prefix of another one should come
+// after it. If the rest of the expression doesn't match after an operator, the expression ends before the
+// operator. An infix or postfix operator that matches without consuming anything ends the expression instead
+// of being applied. The operators and operands are parsed as rules of their own, so their events come in
+// input order; the precedences say how they group.
+ParseRule* OperatorPrecedenceRule_Create(ParseScheme* scheme, ParseRule* operand, const ParseOperator* operators, size_t numOperators);
+
+ParseResult OperatorPrecedenceRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+void OperatorPrecedenceRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void OperatorPrecedenceRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -9,11 +9,9 @@ ParseRule* createOptionListRule(ParseScheme* scheme, ...);
 
 #define OptionListRule_Create(scheme, ...) createOptionListRule(scheme, __VA_ARGS__, NULL)
 
-void OptionListRule_Free(OptionListParseRule* rule);
+ParseResult OptionListRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult OptionListRule_Parse(OptionListParseRule* rule, char* str, ParseResult* result_ret);
-
-void OptionListRule_PrintDeep(OptionListParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
-void OptionListRule_Print(OptionListParseRule* rule, FILE* fout);
+void OptionListRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void OptionListRule_Print(ParseRule* rule, FILE* fout);
 
 #endif
\ No newline at end of file
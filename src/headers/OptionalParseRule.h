@@ -6,11 +6,9 @@
 
 ParseRule* OptionalRule_Create(ParseScheme* scheme, ParseRule* rule);
 
-void OptionalRule_Free(OptionalParseRule* rule);
+ParseResult OptionalRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult OptionalRule_Parse(OptionalParseRule* rule, char* str, ParseResult* result_ret);
-
-void OptionalRule_PrintDeep(OptionalParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
-void OptionalRule_Print(OptionalParseRule* rule, FILE* fout);
+void OptionalRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void OptionalRule_Print(ParseRule* rule, FILE* fout);
 
 #endif
\ No newline at end of file
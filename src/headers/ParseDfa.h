@@ -0,0 +1,57 @@
+#ifndef EKW_PARSER_PARSE_DFA_H
+#define EKW_PARSER_PARSE_DFA_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+struct ParseDfa_s {
+	// Bytes that no rule in the DFA can tell apart share a class, and transitions are stored per class.
+	uint8_t byteClasses[256];
+	size_t numClasses;
+
+	size_t numStates;
+	int32_t startState;
+
+	// numStates * numClasses entries. -1 means that no match can be found past this point.
+	int32_t* transitions;
+
+	// For every state, the index of the rule that matches if the input ends here, or -1 if none does. If
+	// several rules match, the one that was passed to ParseDfa_Compile first wins.
+	int32_t* accepts;
+
+	// For every state, a bit for each of the first 64 rules that matches if the input ends here, and a bit
+	// for each of them that could still match further on.
+	uint64_t* acceptMasks;
+	uint64_t* liveMasks;
+
+	// If set, the DFA follows an option list: the first rule that matches at all wins, instead of the
+	// longest match.
+	bool firstMatchWins;
+};
+
+// Whether a DFA can reproduce the PEG semantics of the rule. This is true for trees of alphabet, string,
+// sequence, option list, optional and repeat rules in which every choice can be made by looking at the
+// next byte.
+bool ParseDfa_IsRegular(ParseRule* rule);
+
+// Builds a minimized DFA that matches any of the rules. Returns NULL if one of them isn't regular, or if
+// the DFA would be too large.
+ParseDfa* ParseDfa_Compile(ParseRule** rules, size_t numRules);
+
+// Builds a DFA that matches the rules as the options of an option list. Each option has to be regular on
+// its own, but unlike in a regular option list, options may start with the same bytes. At most 64 options.
+ParseDfa* ParseDfa_CompileOptions(ParseRule** rules, size_t numRules);
+
+void ParseDfa_Free(ParseDfa* dfa);
+
+// The number of bytes allocated for the DFA, or 0 if it is NULL.
+size_t ParseDfa_MemoryUsage(const ParseDfa* dfa);
+
+// Finds the longest match of any of the DFA's rules at the start of str, or for DFAs built with
+// ParseDfa_CompileOptions, the match of the first rule that matches. Only reads str once, from left to
+// right, and stops as soon as the result can't change. examined_ret is set to the number of bytes that were
+// read, plus one if the end of the input was reached.
+bool ParseDfa_Match(const ParseDfa* dfa, const char* str, size_t len, size_t* length_ret, int* tag_ret, size_t* examined_ret);
+
+#endif
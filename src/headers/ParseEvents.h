@@ -0,0 +1,33 @@
+#ifndef EKW_PARSER_PARSE_EVENTS_H
+#define EKW_PARSER_PARSE_EVENTS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// To get the events of a parse, set its context's events. Events can't be shared by parses that run at the
+// same time.
+ParseEvents* ParseEvents_Create(ParseScheme* scheme);
+
+void ParseEvents_Free(ParseEvents* events);
+
+// Reports the rule's matches to the callback, or stops reporting them if callback is NULL.
+bool ParseEvents_Select(ParseEvents* events, ParseRule* rule, ParseEventCallback callback, void* userData);
+
+// Returns whether a rule's DFA has to be skipped, so that rules inside it can report their events.
+bool ParseEvents_NeedsChildren(ParseEvents* events, ParseRule* rule);
+
+// Called around parsing each rule. ParseEvents_Enter returns how many events were pending, which has to be
+// passed to ParseEvents_Exit so that it can drop the rule's events if it failed. Returns false if the parse
+// has to be aborted.
+size_t ParseEvents_Enter(ParseEvents* events, ParseRule* rule, size_t offset, bool* ok_ret);
+bool ParseEvents_Exit(ParseEvents* events, ParseRule* rule, size_t offset, ParseResult* result, size_t pendingMark);
+
+// Drops the events that became pending after pendingMark, which is how many were pending then. Rules that
+// give up on children that matched, without the rule itself failing, call this.
+void ParseEvents_Retract(ParseEvents* events, size_t pendingMark);
+
+// Passes every pending event on. Only call this when none of them can be dropped anymore.
+bool ParseEvents_Flush(ParseEvents* events);
+
+#endif
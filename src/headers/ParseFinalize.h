@@ -0,0 +1,16 @@
+#ifndef EKW_PARSER_PARSE_FINALIZE_H
+#define EKW_PARSER_PARSE_FINALIZE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Resolves forward rules, turning the ones that only call themselves last into repeat rules, drops the rules
+// that roots don't use, and renumbers the rest in the order they are parsed, so that rules parsed together are
+// close together. roots are updated to point at the rules' new places; every other pointer to a rule of the
+// scheme is invalid afterwards, as are profiles, events, trees and memos made for it before. The scheme can't
+// be changed afterwards. The rules that are kept are linted first, and if ParseScheme_Lint finds an error in
+// them, nothing has been changed yet, so the rules can still be fixed before finalizing again.
+bool ParseScheme_Finalize(ParseScheme* scheme, ParseRule** roots, size_t numRoots);
+
+#endif
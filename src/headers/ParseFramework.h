@@ -3,54 +3,202 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 
 
 typedef struct ParseRule_s ParseRule;
+typedef struct ParseDfa_s ParseDfa;
+typedef struct ParseContext_s ParseContext;
+typedef struct ParseTrace_s ParseTrace;
+typedef struct ParseHeatmap_s ParseHeatmap;
+typedef struct ParseProfile_s ParseProfile;
+typedef struct ParseEvents_s ParseEvents;
+typedef struct ParseTree_s ParseTree;
+typedef struct ParseTreeFile_s ParseTreeFile;
+typedef struct ParseLintReport_s ParseLintReport;
 
 
 // =================
 // Rule type defs...
 // =================
 
+// Rule data is stored inside the rule itself. Rules refer to other rules by their index in the scheme's rule
+// table, and to text by its offset in the scheme's string pool, so that neither changes when those grow.
+
 typedef struct {
-	const char* alphabet;
-	size_t alphabetLen;
+	// Offset of the null-terminated alphabet in the string pool.
+	uint32_t alphabet;
+	uint32_t alphabetLen;
+
+	// If set, alphabet has been lowercased, and input is lowercased before it is looked up.
+	bool caseInsensitive;
 } AlphabetParseRule;
 
 typedef struct {
-	ParseRule** rules;
-	size_t rulesLen;
+	// The indices of the rules in the list are childIndices[firstRule] to childIndices[firstRule + rulesLen - 1]
+	// in the scheme.
+	uint32_t firstRule;
+	uint32_t rulesLen;
+
+	// Only used by sequences. If set, the scheme's skipper is applied in front of each element.
+	bool skip;
 } RulesListRuleData;
 
 typedef RulesListRuleData OptionListParseRule;
 typedef RulesListRuleData SequenceParseRule;
 
 typedef struct {
-	char* string;
-	size_t stringLen;
+	// Offset of the null-terminated string in the string pool.
+	uint32_t string;
+	uint32_t stringLen;
+
+	// If set, string has been lowercased, and input is lowercased before it is compared.
+	bool caseInsensitive;
 } StringParseRule;
 
 typedef struct {
-	ParseRule* rule;
+	uint32_t rule;
 	// bool greedy;
 } OptionalParseRule;
 
 typedef struct {
-	ParseRule* rule;
+	uint32_t rule;
 	size_t minReps;
 	size_t maxReps;
 } RepeatParseRule;
 
+typedef struct {
+	int tokenType;
+} TokenParseRule;
+
+typedef struct {
+	// Only parsed when the region is expanded.
+	uint32_t rule;
+
+	// The rule that finds where the region ends, or UINT32_MAX if the region is a balanced open ... close.
+	uint32_t skipRule;
+
+	// open and close aren't counted between quote characters, and quote doesn't end a quoted part right
+	// after escape. quote and escape are 0 if unused.
+	char open;
+	char close;
+	char quote;
+	char escape;
+} LazyParseRule;
+
+typedef enum {
+	PARSE_OPERATOR_PREFIX,
+	PARSE_OPERATOR_POSTFIX,
+	PARSE_OPERATOR_INFIX_LEFT,
+	PARSE_OPERATOR_INFIX_RIGHT,
+	// Can't be chained with operators of the same precedence, so a < b < c only matches a < b.
+	PARSE_OPERATOR_INFIX_NONE
+} ParseOperatorKind;
+
+typedef struct {
+	ParseRule* rule;
+	ParseOperatorKind kind;
+	// Operators with a higher precedence bind tighter.
+	uint8_t precedence;
+} ParseOperator;
+
+typedef struct {
+	uint32_t operand;
+
+	// The indices of the operators' rules are childIndices[firstOperator] onwards. Their kinds and precedences
+	// are pairs of bytes in the string pool, starting at operatorInfo.
+	uint32_t firstOperator;
+	uint32_t numOperators;
+	uint32_t operatorInfo;
+} OperatorPrecedenceParseRule;
+
+typedef struct {
+	uint32_t item;
+	uint32_t separator;
+	uint32_t minItems;
+	// UINT32_MAX if there is no limit.
+	uint32_t maxItems;
+
+	// If set, a separator after the last item is part of the match.
+	bool allowTrailing;
+} SeparatedListParseRule;
+
+typedef struct {
+	// Offset in the string pool of the stop bytes, followed by the escape byte if there is one.
+	uint32_t stops;
+	uint32_t numStops;
+
+	// The escape byte and the byte after it are always part of the match, even if that is a stop byte. 0 if
+	// unused.
+	char escape;
+
+	// If set, the match can't be empty.
+	bool required;
+} ScanUntilParseRule;
+
+typedef struct {
+	// Owned by the rule if its type has a free function.
+	void* data;
+} CustomParseRule;
+
 
 // =================================
 // Other defs...
 // =================================
 
+// The skipper's bytes are searched for with SimdUtil, which takes at most this many.
+#define PARSE_SKIP_MAX_BYTES 16
+
+typedef struct {
+	// The shortest and longest matches the rule can have. maxLength is SIZE_MAX if there is no limit.
+	size_t minLength;
+	size_t maxLength;
+	// Whether the rule can reach a cut, in which case failing it early could skip a commit.
+	bool canCut;
+} ParseRuleLengths;
+
 typedef struct {
 	ParseRule* rules;
 	size_t numRules;
 	size_t maxRules;
 
+	// The rules of every option list and sequence, as indices into rules. Each list is stored contiguously.
+	uint32_t* childIndices;
+	size_t numChildIndices;
+	size_t maxChildIndices;
+
+	// The text of every alphabet and string rule, each null-terminated.
+	char* stringPool;
+	size_t stringPoolLen;
+	size_t maxStringPoolLen;
+
+	// Indexed like rules. Only allocated by ParseScheme_CompileDfas, and only has an entry for rules that
+	// have hasDfa set.
+	ParseDfa** dfas;
+	size_t maxDfas;
+
+	// Indexed like rules. Only allocated by ParseScheme_ComputeRuleLengths, and only has entries for the rules
+	// that existed then.
+	ParseRuleLengths* ruleLengths;
+	size_t numRuleLengths;
+
+	// An open addressing hash table of rule indices, used to find a rule that is identical to a new one.
+	// Empty slots are UINT32_MAX. It has internTableSize slots, which is 0 or a power of two.
+	bool hashConsing;
+	uint32_t* internTable;
+	size_t internTableSize;
+	size_t numInterned;
+
+	// Sequences created while skipping is on skip these bytes, and comments, in front of each element. Comment
+	// delimiters are offsets in the string pool, or UINT32_MAX if unused.
+	bool skipping;
+	char skipBytes[PARSE_SKIP_MAX_BYTES];
+	size_t numSkipBytes;
+	uint32_t skipLineComment;
+	uint32_t skipBlockCommentStart;
+	uint32_t skipBlockCommentEnd;
+
 
 	/* Here are the meanings of the errorState values:
 	-1	| The ParseScheme has been freed.
@@ -63,6 +211,9 @@ typedef struct {
 	int errorState;
 
 	size_t numUnresolvedForwardRules;
+
+	// Set by ParseScheme_Finalize, after which rules can't be added or changed.
+	bool finalized;
 } ParseScheme;
 
 
@@ -74,7 +225,17 @@ typedef enum {
 	PARSE_RULE_FORWARD_DECLARED,
 	PARSE_RULE_STRING,
 	PARSE_RULE_OPTIONAL,
-	PARSE_RULE_REPEAT
+	PARSE_RULE_REPEAT,
+	PARSE_RULE_CUT,
+	PARSE_RULE_TOKEN,
+	PARSE_RULE_LAZY,
+	PARSE_RULE_SKIP,
+	PARSE_RULE_OPERATOR_PRECEDENCE,
+	PARSE_RULE_SEPARATED_LIST,
+	PARSE_RULE_SCAN_UNTIL,
+
+	// Rule types registered with ParseRuleType_Register are numbered from here.
+	PARSE_RULE_NUM_BUILTIN_TYPES
 } ParseRuleType;
 
 struct ParseRule_s {
@@ -84,18 +245,111 @@ struct ParseRule_s {
 
 	bool wasForwardDeclaration;
 
+	// If the rule is regular, ParseScheme_CompileDfas gives it a DFA that is used instead of parsing its
+	// children one at a time. It is kept in the scheme's dfas table, since most rules don't have one.
+	bool hasDfa;
+
 	ParseScheme* scheme;
 
 	union {
-		AlphabetParseRule* alphabetRule;
-		OptionListParseRule* optionListRule;
-		SequenceParseRule* sequenceRule;
-		StringParseRule* stringRule;
-		OptionalParseRule* optionalRule;
-		RepeatParseRule* repeatRule;
+		AlphabetParseRule alphabetRule;
+		OptionListParseRule optionListRule;
+		SequenceParseRule sequenceRule;
+		StringParseRule stringRule;
+		OptionalParseRule optionalRule;
+		RepeatParseRule repeatRule;
+		TokenParseRule tokenRule;
+		LazyParseRule lazyRule;
+		OperatorPrecedenceParseRule operatorRule;
+		SeparatedListParseRule separatedListRule;
+		ScanUntilParseRule scanUntilRule;
+		CustomParseRule customRule;
 	};
 };
 
+static inline uint32_t Rule_GetIndex(ParseRule* rule) {
+	return (uint32_t) (rule - rule->scheme->rules);
+}
+
+// The i-th rule of an option list or sequence.
+static inline ParseRule* Rule_GetListRule(ParseRule* rule, size_t i) {
+	return rule->scheme->rules + rule->scheme->childIndices[rule->sequenceRule.firstRule + i];
+}
+
+// The rule inside an optional, repeat or lazy rule.
+static inline ParseRule* Rule_GetInnerRule(ParseRule* rule) {
+	uint32_t index;
+	switch(rule->ruleType) {
+		case PARSE_RULE_OPTIONAL:
+			index = rule->optionalRule.rule;
+			break;
+		case PARSE_RULE_REPEAT:
+			index = rule->repeatRule.rule;
+			break;
+		default:
+			index = rule->lazyRule.rule;
+			break;
+	}
+	return rule->scheme->rules + index;
+}
+
+static inline ParseRule* Rule_GetOperandRule(ParseRule* rule) {
+	return rule->scheme->rules + rule->operatorRule.operand;
+}
+
+// The i-th operator of an operator precedence rule.
+static inline ParseRule* Rule_GetOperatorRule(ParseRule* rule, size_t i) {
+	return rule->scheme->rules + rule->scheme->childIndices[rule->operatorRule.firstOperator + i];
+}
+
+static inline ParseOperatorKind Rule_GetOperatorKind(ParseRule* rule, size_t i) {
+	return (ParseOperatorKind) rule->scheme->stringPool[rule->operatorRule.operatorInfo + 2 * i];
+}
+
+static inline uint8_t Rule_GetOperatorPrecedence(ParseRule* rule, size_t i) {
+	return (uint8_t) rule->scheme->stringPool[rule->operatorRule.operatorInfo + 2 * i + 1];
+}
+
+static inline ParseRule* Rule_GetItemRule(ParseRule* rule) {
+	return rule->scheme->rules + rule->separatedListRule.item;
+}
+
+static inline ParseRule* Rule_GetSeparatorRule(ParseRule* rule) {
+	return rule->scheme->rules + rule->separatedListRule.separator;
+}
+
+// The text of an alphabet or string rule.
+static inline const char* Rule_GetText(ParseRule* rule) {
+	uint32_t offset = (rule->ruleType == PARSE_RULE_ALPHABET)? rule->alphabetRule.alphabet : rule->stringRule.string;
+	return rule->scheme->stringPool + offset;
+}
+
+static inline ParseDfa* Rule_GetDfa(ParseRule* rule) {
+	return rule->hasDfa? rule->scheme->dfas[Rule_GetIndex(rule)] : NULL;
+}
+
+static inline size_t Rule_GetMinLength(ParseRule* rule) {
+	uint32_t index = Rule_GetIndex(rule);
+	return (index < rule->scheme->numRuleLengths)? rule->scheme->ruleLengths[index].minLength : 0;
+}
+
+static inline size_t Rule_GetMaxLength(ParseRule* rule) {
+	uint32_t index = Rule_GetIndex(rule);
+	return (index < rule->scheme->numRuleLengths)? rule->scheme->ruleLengths[index].maxLength : SIZE_MAX;
+}
+
+// Whether the rule is certain to fail with only the given number of bytes left, without committing to
+// anything, so that it doesn't have to be parsed.
+static inline bool Rule_CannotMatchWithin(ParseRule* rule, size_t available) {
+	uint32_t index = Rule_GetIndex(rule);
+	if(index >= rule->scheme->numRuleLengths) {
+		return false;
+	}
+
+	ParseRuleLengths* lengths = rule->scheme->ruleLengths + index;
+	return (lengths->minLength > available) && !lengths->canCut;
+}
+
 
 
 
@@ -104,10 +358,456 @@ typedef struct {
 	bool success;
 	char* str;
 	size_t length;
+
+	// Set when the parse passed a CutRule. Once a result is cut, enclosing rules must not backtrack to try
+	// other alternatives: a cut failure fails every rule it propagates through.
+	bool cut;
+
+	// Set when the parse was stopped by one of its context's limits. An aborted result is also a failure,
+	// but says nothing about whether the input matches.
+	bool aborted;
 } ParseResult;
 
+typedef enum {
+	PARSE_NOT_ABORTED,
+	PARSE_ABORTED_STEP_BUDGET,
+	PARSE_ABORTED_CANCELLED,
+	PARSE_ABORTED_DEADLINE,
+	// An event callback asked to stop, or events couldn't be buffered.
+	PARSE_ABORTED_BY_CALLBACK
+} ParseAbortReason;
+
 //extern ParseResult PARSE_RESULT_FAILURE;
 
+// A set of byte values, stored as a 256-bit bitmap.
+typedef struct {
+	uint64_t bits[4];
+} ByteSet;
+
+typedef struct {
+	int tokenType;
+	size_t offset;
+	size_t length;
+} Token;
+
+// What a rule type does. Every rule is dispatched through the entry for its ruleType.
+typedef struct {
+	const char* name;
+
+	ParseResult (*parse)(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+	// Only print is required. Rules that contain other rules should also have printDeep, which prints the rule,
+	// and then if depth < maxDepth, prints contained rules on new lines.
+	void (*print)(ParseRule* rule, FILE* fout);
+	void (*printDeep)(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+
+	// Frees anything the rule owns outside of the scheme. May be NULL.
+	void (*free)(ParseRule* rule);
+
+	// Fills first_ret with the bytes that a non-empty match can start with, and returns whether the rule can
+	// match the empty string. If NULL, the rule is assumed to be able to match anything.
+	bool (*getFirstSet)(ParseRule* rule, ByteSet* first_ret);
+
+	// Replaces each rule that the rule refers to with what map returns for it, in the order they are parsed.
+	// ParseScheme_Finalize moves rules, so rule types that refer to other rules need this. May be NULL.
+	void (*mapRules)(ParseRule* rule, ParseRule* (*map)(ParseRule* child, void* mapData), void* mapData);
+} ParseRuleVTable;
+
+typedef struct {
+	char* input;
+	size_t inputLen;
+
+	// Only the tokens that weren't marked as skipped, in input order.
+	Token* tokens;
+	size_t numTokens;
+
+	// For every input offset (including inputLen), the index of the token that a TokenRule starting at that
+	// offset would match, or -1 if there is none. Offsets inside skipped tokens map to the next token, so
+	// TokenRules consume any skipped input in front of their token.
+	int32_t* tokenAtOffset;
+
+	// If the lexer couldn't match anything at some offset, tokenizing stops there. errorOffset is that
+	// offset, or inputLen if the whole input was tokenized.
+	size_t errorOffset;
+} TokenStream;
+
+typedef struct {
+	int tokenType;
+	bool skip;
+	ParseRule* rule;
+} LexerTokenDef;
+
+typedef struct {
+	LexerTokenDef* defs;
+	size_t numDefs;
+	size_t maxDefs;
+
+	// Built from every def on the first call to Lexer_Tokenize.
+	ParseDfa* dfa;
+
+	// Uses the same values as ParseScheme's errorState.
+	int errorState;
+} Lexer;
+
+typedef struct {
+	uint32_t ruleIndex;
+	bool success;
+	bool cut;
+	size_t length;
+
+	// How many bytes from the entry's offset the parse looked at, plus one if it reached the end of the input.
+	// An edit inside that range invalidates the entry.
+	size_t examinedLen;
+} ParseMemoEntry;
+
+typedef struct {
+	// The column's offset if it is before the gap, or its distance from the end of the input if it is after.
+	size_t key;
+
+	ParseMemoEntry* entries;
+	size_t numEntries;
+	size_t maxEntries;
+
+	size_t maxExaminedLen;
+} ParseMemoColumn;
+
+// Remembers the results of rules at each offset, so that they aren't parsed again. The columns are sorted by
+// offset in a gap buffer, with the gap moved to wherever the last edit or new column was. Columns after the
+// gap are keyed by their distance from the end of the input, so an edit shifts them without touching them.
+typedef struct {
+	// Columns are stored in [firstColumn, gapStart) and [gapEnd, endColumn). Evicting columns frees up space
+	// at either end, which is moved into the gap when the gap fills up.
+	ParseMemoColumn* columns;
+	size_t maxColumns;
+	size_t firstColumn;
+	size_t gapStart;
+	size_t gapEnd;
+	size_t endColumn;
+
+	// The index of the last column that was looked up.
+	size_t hint;
+
+	size_t inputLen;
+
+	// If not 0, columns farthest from the offset being stored are evicted to keep currentBytes under this.
+	size_t budgetBytes;
+	size_t currentBytes;
+	size_t peakBytes;
+	size_t numEvictions;
+
+	// Uses the same values as ParseScheme's errorState. Once allocating fails, no more results are stored.
+	int errorState;
+} ParseMemo;
+
+typedef struct {
+	// What a scheme takes up. payloadBytes is what is allocated for the string pool and child lists, and
+	// payloadUsedBytes how much of that the rules refer to, which isn't counted again in the totals. Rules
+	// that were forward declared share their payload and DFA with another rule, so only one of them counts it.
+	size_t ruleTableBytes;
+	size_t payloadBytes;
+	size_t payloadUsedBytes;
+	size_t dfaBytes;
+
+	// What a memo takes up.
+	size_t memoBytes;
+	size_t peakMemoBytes;
+	size_t numMemoEvictions;
+
+	// The total of everything above, now and at the memo's peak.
+	size_t currentBytes;
+	size_t peakBytes;
+} ParseMemoryStats;
+
+struct ParseContext_s {
+	// The whole input being parsed. Rules must never read at or past input + inputLen.
+	char* input;
+	size_t inputLen;
+
+	// The offset of the furthest cut that the parse has committed to. Nothing will backtrack to before it.
+	size_t cutOffset;
+
+	// The token stream that TokenRules match against, or NULL if the input wasn't tokenized.
+	TokenStream* tokens;
+
+	// If set, results of composite rules are looked up here before parsing them, and stored afterwards. A memo
+	// that the context owns has the columns before each cut dropped, so that it doesn't grow with the input. A
+	// memo that was handed in, like an incremental parser's, keeps them for the next parse.
+	ParseMemo* memo;
+	bool ownsMemo;
+
+	// One past the furthest offset that the parse has looked at so far, which is inputLen + 1 once it has
+	// found the end of the input. Rules update it with ParseContext_MarkExamined.
+	size_t examinedEnd;
+
+	// If set, every rule that is parsed records entering and exiting here.
+	ParseTrace* trace;
+
+	// If set, every byte that a rule looks at is counted here.
+	ParseHeatmap* heatmap;
+
+	// If set, the option that each option list matched with is counted here.
+	ParseProfile* profile;
+
+	// If set, selected rules report entering and exiting here, once it is certain that they matched. Rules
+	// containing selected rules aren't looked up in the memo or matched by their DFA, since that would skip
+	// the events of the rules inside.
+	ParseEvents* events;
+
+	// Every rule parsed counts as a step. Once numSteps reaches nextLimitCheck, the limits below are checked,
+	// so that the common case costs a single comparison.
+	size_t numSteps;
+	size_t nextLimitCheck;
+
+	// If not 0, the parse is aborted after this many steps.
+	size_t maxSteps;
+	// If set, the parse is aborted once another thread sets it.
+	atomic_bool* cancelFlag;
+	// If not 0, the parse is aborted once the monotonic clock passes this, in nanoseconds.
+	uint64_t deadline;
+
+	// Once set, every rule fails with an aborted result, and nothing is memoized.
+	ParseAbortReason abortReason;
+};
+
+typedef struct {
+	// Nanoseconds since the trace was created.
+	uint64_t timestamp;
+
+	size_t offset;
+	// Only set for exits.
+	size_t length;
+
+	uint32_t ruleIndex;
+	bool isExit;
+	bool success;
+} ParseTraceEvent;
+
+// A ring buffer of the rules that parses entered and exited. A trace belongs to one thread, which is the only
+// one recording into it, so recording doesn't need any locking. Once it is full, the oldest events are
+// overwritten.
+struct ParseTrace_s {
+	// Only rules from this scheme are recorded.
+	ParseScheme* scheme;
+
+	ParseTraceEvent* events;
+	// Always a power of two.
+	size_t capacity;
+	// Every event ever recorded, including the overwritten ones.
+	size_t numRecorded;
+
+	// When the trace was created, on the monotonic clock.
+	uint64_t startTime;
+	uint32_t threadId;
+};
+
+typedef struct {
+	// How many times the rule was parsed.
+	size_t attempts;
+	// Bytes the rule looked at itself.
+	size_t bytesRead;
+	// Bytes looked at while this was the innermost backtracking rule being parsed: an option list, or an
+	// optional or repeat around more than a single leaf.
+	size_t bytesReadUnder;
+} ParseHeatmapRuleStats;
+
+// Counts how many times each byte of the input is looked at, to find where a grammar backtracks.
+struct ParseHeatmap_s {
+	ParseScheme* scheme;
+
+	// Has inputLen + 1 entries, the last counting how often the end of the input was checked for.
+	size_t inputLen;
+	uint32_t* readCounts;
+
+	// For each offset, the backtracking rule that most of its reads happened under, if any one did. It is
+	// found with a majority vote, so it only takes a counter per offset. UINT32_MAX is no rule.
+	uint32_t* topRules;
+	uint32_t* topRuleVotes;
+
+	// Indexed like the scheme's rules, for the rules that existed when the heatmap was created.
+	ParseHeatmapRuleStats* ruleStats;
+	size_t numRules;
+
+	size_t totalReads;
+
+	// The rule being parsed, and the innermost backtracking rule being parsed, or UINT32_MAX.
+	uint32_t currentRule;
+	uint32_t currentChoiceRule;
+};
+
+typedef enum {
+	PARSE_EVENT_ENTER,
+	PARSE_EVENT_EXIT
+} ParseEventType;
+
+// Called for each event of a selected rule, in input order. length is only known on exit, and is 0 on enter.
+// Returning false aborts the parse.
+typedef bool (*ParseEventCallback)(ParseRule* rule, ParseEventType type, size_t offset, size_t length, void* userData);
+
+typedef struct {
+	uint32_t ruleIndex;
+	ParseEventType type;
+	size_t offset;
+	size_t length;
+} ParseEvent;
+
+typedef struct {
+	ParseEventCallback callback;
+	void* userData;
+} ParseEventHandler;
+
+// Events are held back while the rules they are in could still fail, and dropped if they do. They are passed
+// on once every rule around them is past the point where it could fail without failing the whole parse: when
+// only option lists, optionals and repeats of at most one required repetition are still being parsed, or
+// after a cut. Events that were passed on are only wrong if the parse as a whole fails.
+struct ParseEvents_s {
+	ParseScheme* scheme;
+
+	// Indexed like the scheme's rules, for the rules that existed when the events were created. Rules without
+	// a callback aren't reported.
+	ParseEventHandler* handlers;
+	size_t numRules;
+
+	// Whether a rule contains a rule with a handler, in which case its DFA can't be used, since that would skip
+	// the rules inside. Worked out again once handlers change.
+	bool* containsHandled;
+	bool containsHandledIsValid;
+
+	ParseEvent* pending;
+	size_t numPending;
+	size_t maxPending;
+
+	// How many of the rules being parsed could still fail after a rule inside them matched.
+	size_t numUnsafeOpen;
+
+	// Uses the same values as ParseScheme's errorState.
+	int errorState;
+};
+
+// A match of a rule in a parse tree.
+typedef struct {
+	uint32_t ruleIndex;
+	// Index of the node's parent in the tree's nodes, or SIZE_MAX for the root.
+	size_t parent;
+	size_t offset;
+	size_t length;
+	size_t numChildren;
+} ParseTreeNode;
+
+// The matches of selected rules, nested the way they were parsed. Nodes are in preorder.
+struct ParseTree_s {
+	ParseScheme* scheme;
+	ParseEvents* events;
+
+	ParseTreeNode* nodes;
+	size_t numNodes;
+	size_t maxNodes;
+
+	// The innermost node that hasn't exited yet, or SIZE_MAX.
+	size_t current;
+	size_t inputLen;
+
+	// Uses the same values as ParseScheme's errorState.
+	int errorState;
+};
+
+// A tree written by ParseTree_Write, mapped into memory. Nodes are decoded as they are visited.
+struct ParseTreeFile_s {
+	uint8_t* data;
+	size_t size;
+
+	// Where the root node starts in data.
+	size_t nodesStart;
+	size_t numNodes;
+	size_t numRules;
+	size_t inputLen;
+};
+
+// A position in a ParseTreeFile. Cursors don't hold anything that has to be freed.
+typedef struct {
+	ParseTreeFile* file;
+
+	uint32_t ruleIndex;
+	size_t offset;
+	size_t length;
+	size_t numChildren;
+
+	// Where the node's first child and its next sibling start in the file's data.
+	size_t childrenStart;
+	size_t nextStart;
+	// The parent's offset, which the siblings' offsets are stored relative to.
+	size_t parentOffset;
+	size_t siblingsLeft;
+} ParseTreeCursor;
+
+typedef enum {
+	// An unbounded repeat of a rule that can match the empty string.
+	PARSE_LINT_NULLABLE_REPEAT,
+	// A rule that can be parsed again at the same offset from inside itself.
+	PARSE_LINT_LEFT_RECURSION,
+	// An option that can't match, since an earlier option always matches first.
+	PARSE_LINT_UNREACHABLE_OPTION,
+	// A rule whose backtracking grows exponentially with how deeply its input is nested.
+	PARSE_LINT_EXPONENTIAL_BACKTRACKING,
+	// A rule that can read the same bytes more than PARSE_LINT_EXPENSIVE_COST times.
+	PARSE_LINT_EXPENSIVE_BACKTRACKING
+} ParseLintIssueType;
+
+typedef struct {
+	ParseLintIssueType type;
+	// Errors are hazards that hang or blow up a parse. Everything else is a warning.
+	bool isError;
+	uint32_t ruleIndex;
+	// The unreachable option, or the rule that recurses back into ruleIndex. UINT32_MAX if there is none.
+	uint32_t otherRuleIndex;
+} ParseLintIssue;
+
+struct ParseLintReport_s {
+	ParseScheme* scheme;
+
+	ParseLintIssue* issues;
+	size_t numIssues;
+	size_t maxIssues;
+	size_t numErrors;
+
+	// Indexed like the scheme's rules. Roughly how many times the rule can read the same byte in the worst
+	// case, or SIZE_MAX if that grows exponentially.
+	size_t* costs;
+	// Set for the rules whose cost keeps growing with the nesting depth, but not exponentially.
+	bool* growsWithDepth;
+};
+
+// How often each option of each option list matched, from training parses.
+struct ParseProfile_s {
+	ParseScheme* scheme;
+
+	// Indexed like the scheme's childIndices, for the lists that existed when the profile was created.
+	size_t* optionMatches;
+	size_t numOptions;
+};
+
+typedef struct {
+	ParseRule* rule;
+
+	char* text;
+	size_t textLen;
+	size_t maxTextLen;
+
+	ParseMemo* memo;
+
+	// Uses the same values as ParseScheme's errorState.
+	int errorState;
+} IncrementalParser;
+
+typedef enum {
+	// After a match, scanning resumes at the end of the match.
+	RULE_SCAN_NON_OVERLAPPING,
+	// Every offset where the rule matches is reported, even inside an earlier match.
+	RULE_SCAN_OVERLAPPING
+} RuleScanMode;
+
+// Called for each match found by a scan, in input order. Returning false stops the scan.
+typedef bool (*RuleScanCallback)(char* match, size_t length, void* userData);
+
 // ======================
 // functions...
 // ======================
@@ -116,16 +816,131 @@ ParseScheme* ParseScheme_Create();
 void ParseScheme_Free(ParseScheme* scheme);
 ParseRule* getSchemeSpaceForNewRule(ParseScheme* scheme);
 void ParseScheme_Print(ParseScheme* scheme, FILE* fout);
+size_t ParseScheme_CompileDfas(ParseScheme* scheme);
+bool ParseScheme_ComputeRuleLengths(ParseScheme* scheme);
+
+// Copy text or a list of rules into the scheme, returning its offset in the string pool or its first index
+// in childIndices. On failure, the scheme's errorState is set and UINT32_MAX is returned.
+uint32_t ParseScheme_AddString(ParseScheme* scheme, const char* str, size_t len);
+uint32_t ParseScheme_AddRulesList(ParseScheme* scheme, ParseRule** rules, size_t numRules);
+
+// Returns a rule identical to the given one if the scheme already has one, in which case the given rule must
+// be the last one created, and is removed again. Otherwise, the rule is remembered and returned. The alphabet,
+// string, sequence, option list, optional and repeat create functions do this, so that a grammar that builds
+// the same rule in many places only has one copy of it. Other rules are returned as they are.
+ParseRule* ParseScheme_InternRule(ParseScheme* scheme, ParseRule* rule);
+// Hash-consing is on by default. Turning it off keeps every rule that is created separate.
+void ParseScheme_SetHashConsing(ParseScheme* scheme, bool hashConsing);
+// Rules that were changed in place have to be hashed again. Rules that became identical to another one stay
+// separate.
+void ParseScheme_RebuildInternTable(ParseScheme* scheme);
+
+bool ParseScheme_Finalize(ParseScheme* scheme, ParseRule** roots, size_t numRoots);
+
+ParseLintReport* ParseScheme_Lint(ParseScheme* scheme);
+void ParseLintReport_Free(ParseLintReport* report);
+void ParseLintReport_Print(ParseLintReport* report, FILE* fout);
+
+// Sets what sequences skip in front of their elements, and turns skipping on for the sequences created from now
+// on. Any of the comment delimiters can be NULL.
+bool ParseScheme_SetSkipper(ParseScheme* scheme, const char* whitespace, const char* lineComment, const char* blockCommentStart, const char* blockCommentEnd);
+
+// Sequences created while skipping is off match contiguous text, which is what tokens should be built from.
+void ParseScheme_SetSkipping(ParseScheme* scheme, bool skipping);
 
 void Rule_Free(ParseRule* rule);
 
+// Adds a rule type, returning its ruleType, or PARSE_RULE_NO_TYPE if no more types can be added. The vtable is
+// copied. Types should be registered before any parsing starts, since the table isn't locked.
+ParseRuleType ParseRuleType_Register(const ParseRuleVTable* vtable);
+const ParseRuleVTable* ParseRuleType_GetVTable(ParseRuleType ruleType);
+
+void ParseContext_Init(ParseContext* ctx, char* input, size_t inputLen);
+void ParseContext_InitWithTokens(ParseContext* ctx, TokenStream* tokens);
+void ParseContext_Free(ParseContext* ctx);
+void ParseContext_MarkExamined(ParseContext* ctx, char* str, size_t len);
+// Memoizes the results of rules for the rest of the context's parses, in a memo of at most budgetBytes (or
+// unbounded, if 0) that is freed along with the context.
+bool ParseContext_EnableMemo(ParseContext* ctx, size_t budgetBytes);
+// Limit the context's parses, which then fail with an aborted result instead of running on. The step budget
+// and timeout start counting when they are set. The cancel flag and deadline are only checked every thousand
+// or so steps.
+void ParseContext_SetStepBudget(ParseContext* ctx, size_t maxSteps);
+void ParseContext_SetCancelFlag(ParseContext* ctx, atomic_bool* cancelFlag);
+void ParseContext_SetTimeout(ParseContext* ctx, uint64_t timeoutNanoseconds);
+
+// Fills stats_ret with the memory the scheme uses. Add a memo's usage with ParseMemo_MemoryStats.
+void ParseScheme_MemoryStats(ParseScheme* scheme, ParseMemoryStats* stats_ret);
+
+ParseMemo* ParseMemo_Create(size_t inputLen);
+void ParseMemo_Free(ParseMemo* memo);
+void ParseMemo_Edit(ParseMemo* memo, size_t offset, size_t removedLen, size_t insertedLen);
+void ParseMemo_DiscardBefore(ParseMemo* memo, size_t offset);
+void ParseMemo_SetBudget(ParseMemo* memo, size_t budgetBytes);
+void ParseMemo_MemoryStats(ParseMemo* memo, ParseMemoryStats* stats_ret);
+
+// Traces hold at least capacity events. Chrome Trace Event JSON can be loaded into chrome://tracing or Perfetto.
+ParseTrace* ParseTrace_Create(ParseScheme* scheme, size_t capacity);
+void ParseTrace_Free(ParseTrace* trace);
+void ParseTrace_Clear(ParseTrace* trace);
+bool ParseTrace_WriteChromeJson(ParseTrace** traces, size_t numTraces, FILE* fout);
+
+ParseProfile* ParseProfile_Create(ParseScheme* scheme);
+void ParseProfile_Free(ParseProfile* profile);
+size_t ParseScheme_ReorderOptions(ParseScheme* scheme, ParseProfile* profile);
+bool ParseScheme_SaveOptionOrder(ParseScheme* scheme, FILE* fout);
+size_t ParseScheme_LoadOptionOrder(ParseScheme* scheme, FILE* fin);
+
+ParseEvents* ParseEvents_Create(ParseScheme* scheme);
+void ParseEvents_Free(ParseEvents* events);
+bool ParseEvents_Select(ParseEvents* events, ParseRule* rule, ParseEventCallback callback, void* userData);
+
+ParseTree* ParseTree_Create(ParseScheme* scheme);
+void ParseTree_Free(ParseTree* tree);
+bool ParseTree_Select(ParseTree* tree, ParseRule* rule);
+ParseResult ParseTree_Parse(ParseTree* tree, ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+bool ParseTree_Write(ParseTree* tree, FILE* fout);
+ParseTreeFile* ParseTreeFile_Open(const char* path);
+void ParseTreeFile_Close(ParseTreeFile* file);
+bool ParseTreeFile_GetRoot(ParseTreeFile* file, ParseTreeCursor* cursor_ret);
+bool ParseTreeCursor_FirstChild(ParseTreeCursor* cursor, ParseTreeCursor* child_ret);
+bool ParseTreeCursor_NextSibling(ParseTreeCursor* cursor, ParseTreeCursor* sibling_ret);
+
+ParseHeatmap* ParseHeatmap_Create(ParseScheme* scheme, size_t inputLen);
+void ParseHeatmap_Free(ParseHeatmap* heatmap);
+double ParseHeatmap_GetAmplification(ParseHeatmap* heatmap);
+void ParseHeatmap_PrintReport(ParseHeatmap* heatmap, FILE* fout, size_t maxHotspots, size_t maxRules);
+
+IncrementalParser* IncrementalParser_Create(ParseRule* rule, const char* text, size_t textLen);
+void IncrementalParser_Free(IncrementalParser* parser);
+ParseResult IncrementalParser_Parse(IncrementalParser* parser, ParseResult* result_ret);
+bool IncrementalParser_Edit(IncrementalParser* parser, size_t offset, size_t removedLen, const char* inserted, size_t insertedLen);
+
+// Parses a null-terminated string.
 ParseResult Rule_Parse(ParseRule* rule, char* str, ParseResult* result_ret);
+ParseResult Rule_ParseWithContext(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+bool Rule_GetFirstSet(ParseRule* rule, ByteSet* first_ret);
+size_t Rule_GetLiteralPrefix(ParseRule* rule, char* prefix_ret, size_t maxLen);
+bool Rule_CanCutBeforeInput(ParseRule* rule);
+bool Rule_AreMutuallyExclusive(ParseRule* a, ParseRule* b);
+
+size_t Rule_Scan(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, RuleScanCallback callback, void* userData);
+size_t Rule_ScanParallel(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, size_t numThreads, RuleScanCallback callback, void* userData);
+
+Lexer* Lexer_Create();
+void Lexer_Free(Lexer* lexer);
+bool Lexer_AddToken(Lexer* lexer, int tokenType, ParseRule* rule);
+bool Lexer_AddSkip(Lexer* lexer, ParseRule* rule);
+TokenStream* Lexer_Tokenize(Lexer* lexer, char* input, size_t inputLen);
+void TokenStream_Free(TokenStream* tokens);
 
 void Rule_PrintSimpleRulePointer(ParseRule* rule, FILE* fout);
 void Rule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
 void Rule_Print(ParseRule* rule, FILE* fout);
 
 ParseResult setParseResult(ParseResult* ptr, bool success, char* str, size_t length);
+ParseResult setParseResultWithCut(ParseResult* ptr, bool success, char* str, size_t length, bool cut);
 //ParseResult useParseResult(ParseResult* ptr, ParseResult toUse);
 
 // ==========================
@@ -136,13 +951,20 @@ ParseResult setParseResult(ParseResult* ptr, bool success, char* str, size_t len
 #define SequenceRule_Create(scheme, ...) createSequenceRule(scheme, __VA_ARGS__, NULL)
 
 ParseRule* AlphabetRule_Create(ParseScheme* scheme, char* str);
+ParseRule* AlphabetRule_CreateCaseInsensitive(ParseScheme* scheme, char* str);
 ParseRule* ForwardRule_Declare(ParseScheme* scheme);
 ParseRule* ForwardRule_SetValue(ParseScheme* scheme, ParseRule* forwardRule, ParseRule* ruleValue);
 ParseRule* createOptionListRule(ParseScheme* scheme, ...);
 ParseRule* createSequenceRule(ParseScheme* scheme, ...);
 ParseRule* StringRule_Create(ParseScheme* scheme, char* str);
+ParseRule* StringRule_CreateCaseInsensitive(ParseScheme* scheme, char* str);
 ParseRule* OptionalRule_Create(ParseScheme* scheme, ParseRule* rule);
 ParseRule* RepeatRule_CreateWithBounds(ParseScheme* scheme, size_t minReps, size_t maxReps, ParseRule* rule);
 ParseRule* RepeatRule_Create(ParseScheme* scheme, bool required, ParseRule* rule);
+ParseRule* CutRule_Create(ParseScheme* scheme);
+ParseRule* TokenRule_Create(ParseScheme* scheme, int tokenType);
+// Creates a rule of a registered type. Custom rules that contain other rules should refer to them with
+// Rule_GetIndex, since the scheme moves its rules when it grows.
+ParseRule* CustomRule_Create(ParseScheme* scheme, ParseRuleType ruleType, void* data);
 
 #endif
\ No newline at end of file
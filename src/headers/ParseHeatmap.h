@@ -0,0 +1,27 @@
+#ifndef EKW_PARSER_PARSE_HEATMAP_H
+#define EKW_PARSER_PARSE_HEATMAP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// To count the reads of a parse, set its context's heatmap. A heatmap can be shared by several parses of the
+// same input, but not by parses on different threads.
+ParseHeatmap* ParseHeatmap_Create(ParseScheme* scheme, size_t inputLen);
+
+void ParseHeatmap_Free(ParseHeatmap* heatmap);
+
+// Makes the rule the one that reads are counted against, until the caller restores the heatmap's
+// currentRule and currentChoiceRule.
+void ParseHeatmap_EnterRule(ParseHeatmap* heatmap, ParseRule* rule);
+
+void ParseHeatmap_Record(ParseHeatmap* heatmap, size_t offset, size_t len);
+
+// Bytes looked at, divided by the length of the input. A parse that never backtracks is close to 1.
+double ParseHeatmap_GetAmplification(ParseHeatmap* heatmap);
+
+// Prints the amplification, the most read offsets with the rule most of their reads were under, and the rules
+// that the most reads happened under.
+void ParseHeatmap_PrintReport(ParseHeatmap* heatmap, FILE* fout, size_t maxHotspots, size_t maxRules);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef EKW_PARSER_PARSE_LINT_H
+#define EKW_PARSER_PARSE_LINT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Rules that can read the same bytes more often than this are reported.
+#define PARSE_LINT_EXPENSIVE_COST 64
+
+// Looks for rules that would hang or blow up a parse, and estimates how much each rule can backtrack. Rules of
+// custom types are assumed to read their input once, and their children aren't checked through them. Without
+// a getFirstSet, nothing is known about what they match, so nothing they could cause is reported as an error.
+// ParseScheme_Finalize runs this, and fails if anything is reported as an error.
+ParseLintReport* ParseScheme_Lint(ParseScheme* scheme);
+
+// The same as ParseScheme_Lint, but only reports issues in the rules whose entry in checked is set.
+ParseLintReport* ParseScheme_LintRules(ParseScheme* scheme, const bool* checked);
+
+void ParseLintReport_Free(ParseLintReport* report);
+
+void ParseLintReport_Print(ParseLintReport* report, FILE* fout);
+
+#endif
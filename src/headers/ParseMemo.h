@@ -0,0 +1,34 @@
+#ifndef EKW_PARSER_PARSE_MEMO_H
+#define EKW_PARSER_PARSE_MEMO_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+ParseMemo* ParseMemo_Create(size_t inputLen);
+
+void ParseMemo_Free(ParseMemo* memo);
+
+// Caps the memory the memo may use, or removes the cap if budgetBytes is 0. Past the budget, the columns
+// farthest from where the parse is storing results are evicted, so a parse never fails because of it.
+void ParseMemo_SetBudget(ParseMemo* memo, size_t budgetBytes);
+
+// Adds the memo's usage to stats_ret, so that it can be combined with ParseScheme_MemoryStats.
+void ParseMemo_MemoryStats(ParseMemo* memo, ParseMemoryStats* stats_ret);
+
+// Returns the stored result of the rule at the offset, or NULL if there is none. The pointer is only valid
+// until the memo is next changed.
+ParseMemoEntry* ParseMemo_Lookup(ParseMemo* memo, size_t offset, uint32_t ruleIndex);
+
+bool ParseMemo_Store(ParseMemo* memo, size_t offset, ParseMemoEntry entry);
+
+// Drops every column before the offset. Once a parse has committed to a cut at the offset, nothing before it
+// is looked up again, so a memo that only lives for one parse can stay as small as the span since the last cut.
+void ParseMemo_DiscardBefore(ParseMemo* memo, size_t offset);
+
+// Updates the memo for an edit that replaced removedLen bytes at offset with insertedLen new bytes. Entries
+// that looked at any of the replaced bytes, or at the spot where bytes were inserted, are dropped, and
+// entries after the edit are moved along with their input.
+void ParseMemo_Edit(ParseMemo* memo, size_t offset, size_t removedLen, size_t insertedLen);
+
+#endif
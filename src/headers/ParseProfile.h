@@ -0,0 +1,29 @@
+#ifndef EKW_PARSER_PARSE_PROFILE_H
+#define EKW_PARSER_PARSE_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// To profile a parse, set its context's profile. Rules created after the profile aren't counted.
+ParseProfile* ParseProfile_Create(ParseScheme* scheme);
+
+void ParseProfile_Free(ParseProfile* profile);
+
+void ParseProfile_RecordOption(ParseProfile* profile, ParseRule* rule, size_t option);
+
+// Moves the options of every option list that matched most often to the front, as far as they can go
+// without passing an option that could match the same input, so that parses give the same results as before.
+// Returns how many option lists changed.
+size_t ParseScheme_ReorderOptions(ParseScheme* scheme, ParseProfile* profile);
+
+// Writes the order of every option list's options, so that the same grammar can be given the same order
+// without profiling it again.
+bool ParseScheme_SaveOptionOrder(ParseScheme* scheme, FILE* fout);
+
+// Applies an order written by ParseScheme_SaveOptionOrder to a scheme built the same way. Orders that don't
+// fit the rule they are for, or that would change what it matches, are skipped. Returns how many option lists
+// changed.
+size_t ParseScheme_LoadOptionOrder(ParseScheme* scheme, FILE* fin);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef EKW_PARSER_PARSE_TRACE_H
+#define EKW_PARSER_PARSE_TRACE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// To trace a parse, set its context's trace. Each thread needs its own trace.
+ParseTrace* ParseTrace_Create(ParseScheme* scheme, size_t capacity);
+
+void ParseTrace_Free(ParseTrace* trace);
+
+// Drops every recorded event, so that the trace can be reused.
+void ParseTrace_Clear(ParseTrace* trace);
+
+void ParseTrace_Record(ParseTrace* trace, ParseRule* rule, bool isExit, size_t offset, size_t length, bool success);
+
+// Writes the events of every trace as Chrome Trace Event JSON, with one track per trace. Rules are named the
+// way Rule_Print prints them. Exits whose enter was overwritten are left out.
+bool ParseTrace_WriteChromeJson(ParseTrace** traces, size_t numTraces, FILE* fout);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef EKW_PARSER_PARSE_TREE_H
+#define EKW_PARSER_PARSE_TREE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Trees record the matches of the rules selected in them. Only rules that existed when the tree was created
+// can be selected.
+ParseTree* ParseTree_Create(ParseScheme* scheme);
+
+void ParseTree_Free(ParseTree* tree);
+
+bool ParseTree_Select(ParseTree* tree, ParseRule* rule);
+
+// Parses str with rule, replacing the tree with the matches of the selected rules. The rule parsed with is
+// selected as well, so that it becomes the root. The tree is empty if the parse fails.
+ParseResult ParseTree_Parse(ParseTree* tree, ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+// Writes the tree in preorder. Each node is its rule's index, its offset relative to its parent's, its length,
+// its number of children, and how many bytes its descendants take up, as LEB128 varints.
+bool ParseTree_Write(ParseTree* tree, FILE* fout);
+
+// Maps a file written by ParseTree_Write. Returns NULL if it can't be read or isn't a tree.
+ParseTreeFile* ParseTreeFile_Open(const char* path);
+
+void ParseTreeFile_Close(ParseTreeFile* file);
+
+// These return false if there is no such node, or if the file is corrupt. The cursor returned can be the one
+// passed in.
+bool ParseTreeFile_GetRoot(ParseTreeFile* file, ParseTreeCursor* cursor_ret);
+bool ParseTreeCursor_FirstChild(ParseTreeCursor* cursor, ParseTreeCursor* child_ret);
+bool ParseTreeCursor_NextSibling(ParseTreeCursor* cursor, ParseTreeCursor* sibling_ret);
+
+#endif
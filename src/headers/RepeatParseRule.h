@@ -8,12 +8,10 @@
 ParseRule* RepeatRule_CreateWithBounds(ParseScheme* scheme, size_t minReps, size_t maxReps, ParseRule* rule);
 ParseRule* RepeatRule_Create(ParseScheme* scheme, bool required, ParseRule* rule);
 
-void RepeatRule_Free(RepeatParseRule* rule);
+ParseResult RepeatRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult RepeatRule_Parse(RepeatParseRule* rule, char* str, ParseResult* result_ret);
+void RepeatRule_Print(ParseRule* rule, FILE* fout);
 
-void RepeatRule_Print(RepeatParseRule* rule, FILE* fout);
-
-void RepeatRule_PrintDeep(RepeatParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void RepeatRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef EKW_PARSER_RULE_ANALYSIS_H
+#define EKW_PARSER_RULE_ANALYSIS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+void ByteSet_Clear(ByteSet* set);
+void ByteSet_Fill(ByteSet* set);
+void ByteSet_Add(ByteSet* set, unsigned char c);
+void ByteSet_AddBothCases(ByteSet* set, unsigned char c);
+bool ByteSet_Contains(const ByteSet* set, unsigned char c);
+void ByteSet_Union(ByteSet* set, const ByteSet* other);
+bool ByteSet_Intersects(const ByteSet* a, const ByteSet* b);
+size_t ByteSet_Count(const ByteSet* set);
+
+// Computes the set of bytes that a non-empty match of the rule can start with. Returns whether the rule can
+// match the empty string.
+bool Rule_GetFirstSet(ParseRule* rule, ByteSet* first_ret);
+
+// The same as Rule_GetFirstSet, but sets known_ret to false if the result depends on a rule of a custom type
+// that has no getFirstSet, which is assumed to match anything, including the empty string.
+bool Rule_GetFirstSetIfKnown(ParseRule* rule, ByteSet* first_ret, bool* known_ret);
+
+// Writes the text that every match of the rule starts with into prefix_ret, up to maxLen bytes, and returns
+// its length.
+size_t Rule_GetLiteralPrefix(ParseRule* rule, char* prefix_ret, size_t maxLen);
+
+// Returns whether the rule can fail with a cut before it has matched any input. Rules of unknown types are
+// assumed to.
+bool Rule_CanCutBeforeInput(ParseRule* rule);
+
+// Returns whether no input can be matched, or committed to with a cut, by both rules: they are non-nullable,
+// their FIRST sets are disjoint, and neither can cut before matching input. Two such options can be tried in
+// either order.
+bool Rule_AreMutuallyExclusive(ParseRule* a, ParseRule* b);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef EKW_PARSER_RULE_LENGTHS_H
+#define EKW_PARSER_RULE_LENGTHS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Works out the shortest and longest match of every rule in the scheme, which Rule_GetMinLength and
+// Rule_GetMaxLength return from then on. Sequences and option lists use them to fail the rules that need more
+// input than is left without parsing them. Rules added afterwards aren't covered, so this is best done once
+// the scheme is complete; ParseScheme_Finalize does it. Rules of custom types are assumed to match anything
+// and to cut.
+bool ParseScheme_ComputeRuleLengths(ParseScheme* scheme);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef EKW_PARSER_RULE_SCAN_H
+#define EKW_PARSER_RULE_SCAN_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Finds the matches of a rule anywhere in buf, like a regex search, and returns how many were reported. At
+// each offset the rule is parsed as usual and the match is whatever it consumes there; empty matches are
+// never reported. Offsets that can't start a match are skipped using the rule's FIRST set and literal
+// prefix, so only a few candidate offsets are actually parsed.
+size_t Rule_Scan(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, RuleScanCallback callback, void* userData);
+
+// Like Rule_Scan, but splits buf into chunks that are scanned on separate threads. Matches are still
+// reported in input order on the calling thread, and are the same as Rule_Scan's. Pass 0 for numThreads to
+// use one thread per processor. Small buffers are scanned on the calling thread.
+size_t Rule_ScanParallel(ParseRule* rule, char* buf, size_t len, RuleScanMode mode, size_t numThreads, RuleScanCallback callback, void* userData);
+
+#endif
@@ -7,8 +7,6 @@
 
 ParseRule* RulesListRuleData_Create(ParseScheme* scheme, va_list varArgs, ParseRuleType ruleType);
 
-void RulesListRuleData_Free(RulesListRuleData* data);
-
-void RulesListRuleData_PrintDeep(RulesListRuleData* data, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void RulesListRuleData_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef EKW_PARSER_SCAN_UNTIL_PARSE_RULE_H
+#define EKW_PARSER_SCAN_UNTIL_PARSE_RULE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// The most stop bytes a scan can look for, counting the escape byte.
+#define SCAN_UNTIL_MAX_STOPS 16
+
+// Matches every byte up to the first of the stop bytes, or the end of the input, without matching the stop
+// byte itself. If escape isn't 0, an escape byte and the byte after it are matched as a pair, so a quoted
+// string's body is ScanUntilRule_Create(scheme, "\"", '\\', false). An escape byte at the very end of the
+// input isn't matched. Up to SCAN_UNTIL_MAX_STOPS bytes can be stopped at, including the escape byte.
+ParseRule* ScanUntilRule_Create(ParseScheme* scheme, const char* stops, char escape, bool required);
+
+ParseResult ScanUntilRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+void ScanUntilRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef EKW_PARSER_SEPARATED_LIST_PARSE_RULE_H
+#define EKW_PARSER_SEPARATED_LIST_PARSE_RULE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "ParseFramework.h"
+
+// Matches item (separator item)*, with between minItems and maxItems items, in one loop. A separator that
+// isn't followed by an item is left out of the match, unless allowTrailing is set. maxItems can be SIZE_MAX
+// for no limit. The list stops early if a separator and item match nothing, rather than repeating forever.
+ParseRule* SeparatedListRule_Create(ParseScheme* scheme, ParseRule* item, ParseRule* separator, size_t minItems, size_t maxItems, bool allowTrailing);
+
+ParseResult SeparatedListRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+// Parses a separated list rule on its own, and sets numItems_ret to how many items it matched. The offsets of
+// the first maxOffsets items from str go in offsets_ret, which can be NULL if maxOffsets is 0. The rule's own
+// events and memo entries are skipped, but the items and separators are parsed as usual.
+ParseResult SeparatedListRule_ParseItems(ParseRule* rule, ParseContext* ctx, char* str, size_t* offsets_ret, size_t maxOffsets, size_t* numItems_ret, ParseResult* result_ret);
+
+void SeparatedListRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void SeparatedListRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -9,11 +9,9 @@ ParseRule* createSequenceRule(ParseScheme* scheme, ...);
 
 #define SequenceRule_Create(scheme, ...) createSequenceRule(scheme, __VA_ARGS__, NULL)
 
-void SequenceRule_Free(SequenceParseRule* rule);
+ParseResult SequenceRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult SequenceRule_Parse(SequenceParseRule* rule, char* str, ParseResult* result_ret);
-
-void SequenceRule_PrintDeep(SequenceParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
-void SequenceRule_Print(SequenceParseRule* rule, FILE* fout);
+void SequenceRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void SequenceRule_Print(ParseRule* rule, FILE* fout);
 
 #endif
\ No newline at end of file
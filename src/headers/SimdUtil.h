@@ -0,0 +1,22 @@
+#ifndef EKW_PARSER_SIMD_UTIL_H
+#define EKW_PARSER_SIMD_UTIL_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Lowercases an ASCII letter without branching, and leaves every other byte alone.
+#define SIMD_FOLD_ASCII_CASE(c) ((unsigned char) ((c) | ((((unsigned char) ((c) - 'A')) < 26) << 5)))
+
+// Whether the first len bytes of str equal lowercase once str's ASCII letters are lowercased. lowercase
+// must already be folded.
+bool SimdUtil_EqualsFolded(const char* str, const char* lowercase, size_t len);
+
+// Returns the index of the first byte of str that is one of the given bytes, or len if there is none. At
+// most 16 bytes can be searched for at once.
+size_t SimdUtil_FindAnyOf(const char* str, size_t len, const char* bytes, size_t numBytes);
+
+// Returns the index of the first byte of str that isn't one of the given bytes, or len if there is none. At
+// most 16 bytes can be given.
+size_t SimdUtil_SkipAnyOf(const char* str, size_t len, const char* bytes, size_t numBytes);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef EKW_PARSER_SKIP_PARSE_RULE_H
+#define EKW_PARSER_SKIP_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+// Matches whatever the scheme's skipper skips, which can be nothing. Useful at the end of a grammar, since
+// sequences only skip in front of their elements.
+ParseRule* SkipRule_Create(ParseScheme* scheme);
+
+ParseResult SkipRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+void SkipRule_Print(ParseRule* rule, FILE* fout);
+
+// Returns how many bytes at str the scheme's skipper skips.
+size_t SkipRule_Skip(ParseScheme* scheme, ParseContext* ctx, char* str);
+
+#endif
@@ -6,12 +6,11 @@
 #include "ParseFramework.h"
 
 ParseRule* StringRule_Create(ParseScheme* scheme, char* str);
+ParseRule* StringRule_CreateCaseInsensitive(ParseScheme* scheme, char* str);
 
-void StringRule_Free(StringParseRule* rule);
+ParseResult StringRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
 
-ParseResult StringRule_Parse(StringParseRule* rule, char* str, ParseResult* result_ret);
-
-// void StringRule_PrintDeep(StringParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
-void StringRule_Print(StringParseRule* rule, FILE* fout);
+// void StringRule_PrintDeep(ParseRule* rule, FILE* fout, size_t depth, size_t maxDepth, char* indentStr);
+void StringRule_Print(ParseRule* rule, FILE* fout);
 
 #endif
\ No newline at end of file
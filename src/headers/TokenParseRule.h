@@ -0,0 +1,13 @@
+#ifndef EKW_PARSER_TOKEN_PARSE_RULE_H
+#define EKW_PARSER_TOKEN_PARSE_RULE_H
+
+#include <stdio.h>
+#include "ParseFramework.h"
+
+ParseRule* TokenRule_Create(ParseScheme* scheme, int tokenType);
+
+ParseResult TokenRule_Parse(ParseRule* rule, ParseContext* ctx, char* str, ParseResult* result_ret);
+
+void TokenRule_Print(ParseRule* rule, FILE* fout);
+
+#endif
@@ -14,11 +14,11 @@ int main(int argc, char** argv) {
 
 	ParseRule* unsignedIntegerExponentialLiteral = SequenceRule_Create(scheme,
 		base10UnsignedIntegerLiteral,
-		AlphabetRule_Create(scheme, "eE"),
+		AlphabetRule_CreateCaseInsensitive(scheme, "e"),
 		base10UnsignedIntegerLiteral
 	);
 
-	ParseRule* base16Digit = AlphabetRule_Create(scheme, "0123456789ABCDEFabcdef");
+	ParseRule* base16Digit = AlphabetRule_CreateCaseInsensitive(scheme, "0123456789abcdef");
 	// ParseRule* base16SignlessInteger = ForwardRule_Declare(scheme);
 	// ForwardRule_SetValue(scheme, base16SignlessInteger, SequenceRule_Create(scheme,
 	// 	base16Digit, OptionalRule_Create(scheme, base16SignlessInteger)
@@ -71,6 +71,8 @@ int main(int argc, char** argv) {
 		integerLiteral,
 		RepeatRule_Create(scheme, false, SequenceRule_Create(scheme,
 			StringRule_Create(scheme, " "),
+			// Once we've seen a separator, another integer has to follow.
+			CutRule_Create(scheme),
 			integerLiteral
 		))
 	);
@@ -95,6 +97,8 @@ int main(int argc, char** argv) {
 	// 	abcs
 	// ));
 
+	ParseScheme_CompileDfas(scheme);
+
 	ParseScheme_Print(scheme, stdout);
 	printf("\n=======\n\n");
 